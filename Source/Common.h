@@ -0,0 +1,24 @@
+/*Tetris
+Description: Types shared between the game source files.
+*/
+
+#pragma once
+
+#include <cstddef>
+
+//Define some useful types
+typedef unsigned char uint8;
+typedef signed char	sint8; 
+typedef unsigned short uint16; 
+typedef signed short sint16; 
+typedef unsigned int uint32; 
+typedef signed int sint32; 
+typedef unsigned long long uint64; 
+typedef signed long long sint64; 
+
+class Vec2{
+public:
+	Vec2(int _x, int _y) { x = _x; y = _y; }
+	signed int x; 
+	signed int y; 
+};
@@ -0,0 +1,132 @@
+#include "DrawList.h"
+
+#include <cstring>
+
+namespace{
+
+	// Appends two triangles covering left, top -> right, bottom with the given texture coordinates
+	void addQuad(DrawList& list, float left, float top, float right, float bottom,
+				 float texLeft, float texRight){
+
+		float* _tex = &list.textureCoords[list.texBufferSize];
+		float* _vert = &list.vertices[list.vertBufferSize];
+
+		// Every two represents a vertex 
+		_tex[0] = texLeft;
+		_tex[1] = 1;
+		_tex[2] = texRight;
+		_tex[3] = 1;
+		_tex[4] = texRight;
+		_tex[5] = 0;
+		_tex[6] = texLeft;
+		_tex[7] = 0;
+		_tex[8] = texLeft;
+		_tex[9] = 1;
+		_tex[10] = texRight;
+		_tex[11] = 0;
+
+		// Every three represents a vertex 
+		_vert[0] = left;
+		_vert[1] = top;
+		_vert[2] = 0;
+
+		_vert[3] = right;
+		_vert[4] = top;
+		_vert[5] = 0;
+
+		_vert[6] = right;
+		_vert[7] = bottom;
+		_vert[8] = 0;
+
+		_vert[9] = left;
+		_vert[10] = bottom;
+		_vert[11] = 0;
+
+		_vert[12] = left;
+		_vert[13] = top;
+		_vert[14] = 0;
+
+		_vert[15] = right;
+		_vert[16] = bottom;
+		_vert[17] = 0;
+
+		list.texBufferSize += 12;
+		list.vertBufferSize += 18;
+	}
+
+	// Appends the cell at x, y textured with the given tile of the atlas
+	void addCell(DrawList& list, const Vec2& tLeft, int x, int y, int tile){
+		float _texWidth = 1.0f / 8;
+		float _texStartX = tile * _texWidth;
+
+		addQuad(list, (float)tLeft.x + x, (float)tLeft.y - y, (float)tLeft.x + x + 1, (float)tLeft.y - y - 1,
+				_texStartX, _texStartX + _texWidth);
+	}
+
+}
+
+void genBlockBuffer(DrawList& list, const uint8* grid, Vec2 gridSize,
+					const uint8* currentBlock, Vec2 blockPosition, uint8 currentBlockID){
+
+	// Enough room for every cell in the grid + the 4x4 falling block + the background
+	int _maxCells = (gridSize.x * gridSize.y) + 16 + 1;
+	if ((int)list.vertices.size() < _maxCells * 18){
+		list.vertices.resize(_maxCells * 18);
+		list.textureCoords.resize(_maxCells * 12);
+	}
+
+	//Top left quardinates 
+	Vec2 tLeft(-gridSize.x / 2, gridSize.y / 2);
+
+	list.vertBufferSize = 0; 
+	list.texBufferSize = 0; 
+
+	// Board background first so the blocks are drawn over it, negative texture coordinates 
+	// tell the shader to draw the grid lines instead of sampling the atlas
+	addQuad(list, (float)tLeft.x, (float)tLeft.y, (float)tLeft.x + gridSize.x, (float)tLeft.y - gridSize.y, -1, -1);
+
+	// Assign vertices for current block 
+	for (int p = 0; p < 4; p++){
+		for (int q = 0; q < 4; q++){
+			if (currentBlock[(q * 4) + p] == 1){
+				int _gridX = blockPosition.x - 1 + p;
+				int _gridY = blockPosition.y - 1 + q;
+
+				// If  outside grid bounds 
+				if (_gridX < 0 || _gridY < 0)
+					continue;
+
+				addCell(list, tLeft, _gridX, _gridY, currentBlockID);
+			}
+		}
+	}
+
+	// Blocks already placed in the grid
+	for (int x = 0; x < gridSize.x; x++){
+		for (int y = 0; y < gridSize.y; y++){
+			if (grid[(y*gridSize.x) + x] > 0){
+				addCell(list, tLeft, x, y, grid[(y*gridSize.x) + x] - 1);
+			}
+		}
+	}
+}
+
+void genBoardCells(uint8* cells, const uint8* grid, Vec2 gridSize,
+				   const uint8* currentBlock, Vec2 blockPosition, uint8 currentBlockID){
+
+	memcpy(cells, grid, gridSize.x * gridSize.y);
+
+	for (int p = 0; p < 4; p++){
+		for (int q = 0; q < 4; q++){
+			if (currentBlock[(q * 4) + p] == 1){
+				int _gridX = blockPosition.x - 1 + p;
+				int _gridY = blockPosition.y - 1 + q;
+
+				if (_gridX < 0 || _gridY < 0 || _gridX >= gridSize.x || _gridY >= gridSize.y)
+					continue;
+
+				cells[(_gridY * gridSize.x) + _gridX] = currentBlockID + 1;
+			}
+		}
+	}
+}
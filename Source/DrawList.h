@@ -0,0 +1,34 @@
+/*Tetris
+Description: Per frame draw lists. 
+
+			The game side fills a DrawList with the vertex data for the frame, once submitted 
+			it is treated as immutable and handed to the render thread which uploads + draws it.
+			Nothing in here touches OpenGL so lists can be built on any thread.
+*/
+
+#pragma once
+
+#include <vector>
+
+#include "Common.h"
+
+//!< Vertex data for a single frame
+struct DrawList{
+	std::vector <float> vertices;		//!< Holds vertex positions, 3 floats per vertex 
+	std::vector <float> textureCoords;	//!< Holds texture coordinates, 2 floats per vertex 
+	int vertBufferSize = 0;				//!< Floats used in vertices
+	int texBufferSize = 0;				//!< Floats used in textureCoords
+	uint32 frame = 0;					//!< Incremented by the producer for each list built
+
+	std::vector <uint8> boards;			//!< Spectator wall, cell values (tile + 1, 0 empty) of each board back to back
+	int boardCount = 0;					//!< Boards in the list, 0 when drawing the single game
+};
+
+//!< Generates/ regenerates the vertex data for the blocks in the grid + the falling block. 
+//!< Buffers are only grown, rebuilding a list does not allocate once it has reached full size.
+void genBlockBuffer(DrawList& list, const uint8* grid, Vec2 gridSize, 
+					const uint8* currentBlock, Vec2 blockPosition, uint8 currentBlockID);
+
+//!< Writes the cell values of a board with the falling block merged in, gridSize.x * gridSize.y bytes
+void genBoardCells(uint8* cells, const uint8* grid, Vec2 gridSize, 
+				   const uint8* currentBlock, Vec2 blockPosition, uint8 currentBlockID);
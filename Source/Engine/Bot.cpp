@@ -0,0 +1,296 @@
+#include "Bot.h"
+
+#include "Encoders.h"
+#include "Trace.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace{
+
+	typedef std::chrono::steady_clock Clock;
+
+	// Score of the board alone, lines cleared are added by the caller as they depend on the search
+	float evaluate(const Game& game, const float* weights){
+		float _features[FEATURE_COUNT];
+		boardFeatures(game, 0, _features);
+
+		float _score = 0;
+		for (int _f = 0; _f < FEATURE_COUNT; _f++)
+			_score += weights[_f] * _features[_f];
+		return _score;
+	}
+
+	// Board + the blocks the search looks at, a search's answer only holds for all of them
+	uint64 searchKey(const Game& game, int lookahead){
+		uint64 _blocks = game.getCurrentBlockID() + 1;
+		for (int _p = 0; _p < lookahead; _p++)
+			_blocks = (_blocks << 3) | game.getPreview(_p);
+		return boardHash(game) ^ (_blocks * 0x9E3779B97F4A7C15ull);
+	}
+
+	template <typename T>
+	bool higherScore(const T& a, const T& b){
+		return a.score > b.score;
+	}
+
+}
+
+void boardFeatures(const Game& game, uint32 linesCleared, float* features){
+	float _encoded[ENCODED_FEATURE_COUNT];
+	encodeFeatures(game, _encoded);
+
+	float _height = 0;
+	for (int _x = 0; _x < boardColumns; _x++)
+		_height += _encoded[ENCODED_HEIGHTS + _x];
+
+	features[FEATURE_HEIGHT] = _height;
+	features[FEATURE_HOLES] = _encoded[ENCODED_HOLES];
+	features[FEATURE_BUMPINESS] = _encoded[ENCODED_BUMPINESS];
+	features[FEATURE_WELLS] = _encoded[ENCODED_WELLS];
+	features[FEATURE_LINES] = (float)linesCleared;
+}
+
+Bot::Bot(const BotSettings& _settings) : settings(_settings), table(std::max(_settings.tableMB, 0)), scheduler(_settings.threads){
+	const int _previewSize = Game::previewSize;		// std::min takes a reference, the constant has no storage
+	settings.lookahead = std::min(std::max(settings.lookahead, 0), _previewSize);
+	settings.beamWidth = std::max(settings.beamWidth, 1);
+
+	candidates.resize(scheduler.workerCount());
+	moveGens.resize(scheduler.workerCount());
+	memset(expectedBlock, 0, sizeof(expectedBlock));
+}
+
+void Bot::expandTask(Scheduler& scheduler, int worker, void* data){
+	ExpandRange _range = *(ExpandRange*)data;
+
+	// Hand the top half to anyone idle, keep the bottom
+	while (_range.end - _range.begin > 1){
+		ExpandRange _half = _range;
+		_half.begin = (_range.begin + _range.end) / 2;
+		scheduler.spawn(*_range.group, &Bot::expandTask, _half, worker);
+		_range.end = _half.begin;
+	}
+	_range.bot->expand(_range.begin, worker);
+}
+
+void Bot::expand(int index, int worker){
+	if (outOfTime.load(std::memory_order_relaxed))
+		return;
+	if (Clock::now() > deadline){
+		outOfTime = true;
+		return;
+	}
+
+	// The task's own copy, the beam is only read
+	const Node& _parent = beam[index];
+	Game _game = _parent.game;
+	_game.spawn(levelBlock);
+	if (_game.isGameOver())
+		return;
+
+	MoveGen& _moveGen = moveGens[worker];
+	std::vector<Node>& _out = candidates[worker];
+
+	int _count = _moveGen.generate(_game);
+	for (int _p = 0; _p < _count; _p++){
+		Node _child = { _game, 0, _parent.root };
+		if (!_moveGen.apply(_p, _child.game) || !score(_child, level))
+			continue;
+		_out.push_back(_child);
+	}
+}
+
+bool Bot::score(Node& node, int depth){
+	uint64 _key = boardHash(node.game);
+	TransData _data;
+	if (table.probe(_key, _data)){
+		if (_data.generation == generation && _data.depth == depth)
+			return false;
+	}
+	else{
+		_data.score = evaluate(node.game, settings.weights);
+	}
+
+	// The same board is always the same number of lines on, the first root to reach it is kept
+	_data.depth = (uint8)depth;
+	_data.generation = generation;
+	_data.best = rootMoves.placement(node.root);
+	table.store(_key, _data);
+
+	node.score = _data.score + settings.weights[FEATURE_LINES] * (node.game.getLinesCleared() - rootLines);
+	return true;
+}
+
+int Bot::search(const Game& game){
+	// First level is a single board, done here
+	beam.clear();
+	for (int _p = 0; _p < rootMoves.count(); _p++){
+		Node _node = { game, 0, (uint8)_p };
+		_node.game.setEndless(false);
+		if (!rootMoves.apply(_p, _node.game) || !score(_node, 0))
+			continue;
+		beam.push_back(_node);
+	}
+
+	// Every placement tops out, any will do 
+	int _best = 0;
+	if (!beam.empty()){
+		std::sort(beam.begin(), beam.end(), higherScore<Node>);
+		if ((int)beam.size() > settings.beamWidth)
+			beam.resize(settings.beamWidth);
+		_best = beam[0].root;
+		lastDepth = 1;
+	}
+
+	std::vector<Node> _next;
+	for (level = 1; level <= settings.lookahead && !beam.empty(); level++){
+		levelBlock = game.getPreview(level - 1);
+		outOfTime = false;
+		for (size_t _w = 0; _w < candidates.size(); _w++)
+			candidates[_w].clear();
+
+		Scheduler::Group _group;
+		ExpandRange _range = { this, &_group, 0, (int)beam.size() };
+		scheduler.spawn(_group, &Bot::expandTask, _range, 0);
+		scheduler.wait(_group, 0);
+
+		// An unfinished level would favour whichever boards happened to be expanded first
+		if (outOfTime)
+			break;
+
+		_next.clear();
+		for (size_t _w = 0; _w < candidates.size(); _w++)
+			_next.insert(_next.end(), candidates[_w].begin(), candidates[_w].end());
+		if (_next.empty())
+			break;
+
+		size_t _keep = std::min(_next.size(), (size_t)settings.beamWidth);
+		std::partial_sort(_next.begin(), _next.begin() + _keep, _next.end(), higherScore<Node>);
+		_next.resize(_keep);
+		beam.swap(_next);
+
+		_best = beam[0].root;
+		lastDepth = level + 1;
+	}
+	return _best;
+}
+
+bool Bot::think(const Game& game){
+	// One span for the search, not one per board it places
+	TRACE_SCOPE("think");
+	TRACE_MUTE();
+
+	Clock::time_point _start = Clock::now();
+	deadline = _start + std::chrono::microseconds((long long)(settings.thinkMS * 1000));
+	planned = false;
+	lastDepth = 0;
+
+	// After a wrap entries of an old search would pass for this one's, so they go
+	generation = (generation + 1) & TransTable::maxGeneration;
+	if (generation == 0)
+		table.clear();
+
+	int _rootCount = rootMoves.generate(game);
+	if (_rootCount == 0)
+		return false;
+	rootLines = game.getLinesCleared();
+
+	// Searched in full before, the answer stands if its placement can still be reached
+	uint64 _searchKey = searchKey(game, settings.lookahead);
+	TransData _known;
+	int _best = -1;
+	if (table.probe(_searchKey, _known) && _known.depth > settings.lookahead){
+		for (int _p = 0; _p < _rootCount && _best < 0; _p++){
+			const Placement& _placement = rootMoves.placement(_p);
+			if (_placement.x == _known.best.x && _placement.y == _known.best.y && _placement.rotation == _known.best.rotation)
+				_best = _p;
+		}
+		if (_best >= 0)
+			lastDepth = _known.depth;
+	}
+
+	if (_best < 0){
+		_best = search(game);
+		if (lastDepth > settings.lookahead){
+			TransData _result = { beam[0].score, (uint8)lastDepth, generation, rootMoves.placement(_best) };
+			table.store(_searchKey, _result);
+		}
+	}
+
+	pathLength = rootMoves.path(_best, path, MoveGen::maxPath);
+	if (pathLength < 0)
+		return false;
+	lastPlacement = rootMoves.placement(_best);
+	pathIndex = 0;
+	planned = true;
+	expectedPosition = game.getBlockPosition();
+	memcpy(expectedBlock, game.getCurrentBlock(), sizeof(expectedBlock));
+
+	lastThinkMS = std::chrono::duration<float, std::milli>(Clock::now() - _start).count();
+	return true;
+}
+
+bool Bot::onPlan(const Game& game) const{
+	Vec2 _position = game.getBlockPosition();
+	return _position.x == expectedPosition.x && _position.y == expectedPosition.y &&
+		memcmp(game.getCurrentBlock(), expectedBlock, sizeof(expectedBlock)) == 0;
+}
+
+bool Bot::nextInput(Game& game){
+	// Plan done, the block can only lock from here
+	if (pathIndex >= pathLength){
+		planned = false;
+		return game.dropDown();
+	}
+
+	bool _moved = false;
+	switch (path[pathIndex++]){
+	case MOVE_LEFT: _moved = game.moveLeft(); break;
+	case MOVE_RIGHT: _moved = game.moveRight(); break;
+	case MOVE_ROTATE: _moved = game.rotateBlock(); break;
+	case MOVE_DOWN: _moved = !game.dropDown(); break;
+	}
+
+	expectedPosition = game.getBlockPosition();
+	memcpy(expectedBlock, game.getCurrentBlock(), sizeof(expectedBlock));
+	if (!_moved)
+		planned = false;
+	return _moved;
+}
+
+bool Bot::play(Game& game){
+	if (!think(game))
+		return false;
+
+	while (pathIndex < pathLength){
+		if (!nextInput(game))
+			return false;
+	}
+	return nextInput(game);
+}
+
+void Bot::reset(){
+	table.clear();
+	generation = 0;
+	planned = false;
+	pathLength = 0;
+	pathIndex = 0;
+	inputElapsed = 0;
+	lastThinkMS = 0;
+	lastDepth = 0;
+	lastPlacement = Placement();
+}
+
+void Bot::drive(Game& game, float tickMS){
+	inputElapsed += tickMS;
+	if (inputElapsed < settings.inputMS || game.isGameOver())
+		return;
+	inputElapsed = 0;
+
+	if ((!planned || !onPlan(game)) && !think(game))
+		return;
+
+	nextInput(game);
+}
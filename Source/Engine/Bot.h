@@ -0,0 +1,136 @@
+/*Tetris
+Description: Computer player, picks a placement with a beam search over the preview.
+
+			Boards are scored with the classic hand made features (aggregate height, holes,
+			bumpiness, wells, lines cleared). Each level of the search places the next block of
+			the preview on every board in the beam with MoveGen, the best beamWidth results go on
+			to the next level. A level is expanded by tasks on a work stealing Scheduler, each
+			splits its range of the beam in half until it has a single board to work on, so boards
+			that die straight away do not leave threads idle. The search stops at the time budget
+			and uses the deepest level it finished.
+
+			Boards go through a TransTable: a board another line of the search already reached at
+			the same level is dropped so the beam is not filled with copies, and a board seen by an
+			earlier search reuses its evaluation. Whole searches are kept too, thinking again about
+			the same board + blocks (drive() after gravity moved the block) reuses the answer.
+
+			The chosen placement is played with the same moveLeft/ moveRight/ rotateBlock/
+			dropDown calls a player's input makes, either all at once (play()) or one input at
+			a time (drive()) for a frontend to show.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+#include "Game.h"
+#include "MoveGen.h"
+#include "Scheduler.h"
+#include "TransTable.h"
+
+enum BOT_FEATURE{
+	FEATURE_HEIGHT,			//!< Sum of the column heights
+	FEATURE_HOLES,			//!< Empty cells with a filled cell somewhere above them
+	FEATURE_BUMPINESS,		//!< Sum of the height differences between neighbouring columns
+	FEATURE_WELLS,			//!< Sum of how far each column is below both of its neighbours
+	FEATURE_LINES,			//!< Lines cleared since the search started
+	FEATURE_COUNT
+};
+
+//!< Writes the FEATURE_COUNT features of game's grid, linesCleared is used as FEATURE_LINES
+void boardFeatures(const Game& game, uint32 linesCleared, float* features);
+
+struct BotSettings{
+	int beamWidth = 32;			//!< Boards kept at each level
+	int lookahead = 2;			//!< Preview blocks searched after the falling one, up to Game::previewSize
+	float thinkMS = 10;			//!< Time budget for each block
+	int threads = 0;			//!< Threads searching (the caller's included), 0 for one per core
+	float inputMS = 50;			//!< drive() only, time between inputs
+	int tableMB = 16;			//!< Transposition table size, 0 for none
+
+	//!< Feature weights, a board scores the weighted sum of its features
+	float weights[FEATURE_COUNT] = { -0.510066f, -0.35663f, -0.184483f, -0.1f, 0.760666f };
+};
+
+class Bot{
+public:
+	explicit Bot(const BotSettings& settings = BotSettings());
+
+	//!< Picks where game's falling block goes, returns false if it has nowhere to go
+	bool think(const Game& game);
+
+	//!< Thinks then plays the whole placement at once, returns false if the block could not be placed
+	bool play(Game& game);
+
+	//!< Plays one input every inputMS of tickMS, thinking again for each new block or whenever
+	//!< the block is not where the plan expects (gravity moved it)
+	void drive(Game& game, float tickMS);
+
+	//!< Forgets every earlier search + plan, the next game plays as it would with a new bot
+	void reset();
+
+	float getLastThinkMS() const { return lastThinkMS; }
+	int getLastDepth() const { return lastDepth; }		//!< Levels the last think() finished
+	const Placement& getLastPlacement() const { return lastPlacement; }		//!< Chosen by the last think()
+
+private:
+	struct Node{
+		Game game;			//!< Block placed, next block not spawned
+		float score;
+		uint8 root;			//!< Placement of the falling block this board came from
+	};
+
+	//!< Task data, a range of the beam to expand
+	struct ExpandRange{
+		Bot* bot;
+		Scheduler::Group* group;
+		int begin;
+		int end;
+	};
+
+	// Splits the range until one board is left then expands it, on any worker
+	static void expandTask(Scheduler& scheduler, int worker, void* data);
+	void expand(int index, int worker);
+
+	// Beam search from game's falling block (rootMoves generated), returns the root placement to play
+	int search(const Game& game);
+
+	// Scores node, false if this search already reached its board at depth
+	bool score(Node& node, int depth);
+
+	// Applies the next input of the plan, returns false if it failed
+	bool nextInput(Game& game);
+	bool onPlan(const Game& game) const;
+
+	BotSettings settings;
+
+	MoveGen rootMoves;
+	uint8 path[MoveGen::maxPath];
+	int pathLength = 0;
+	int pathIndex = 0;
+	bool planned = false;
+	Vec2 expectedPosition = Vec2(0, 0);
+	uint8 expectedBlock[16];
+	float inputElapsed = 0;
+
+	float lastThinkMS = 0;
+	int lastDepth = 0;
+	Placement lastPlacement = {};
+
+	// Level being expanded, read by the tasks
+	std::vector<Node> beam;
+	std::vector<std::vector<Node>> candidates;		//!< One per worker
+	std::vector<MoveGen> moveGens;					//!< One per worker
+	uint8 levelBlock = 0;
+	int level = 0;								//!< Depth of the boards being made
+	uint32 rootLines = 0;
+	std::chrono::steady_clock::time_point deadline;
+	std::atomic<bool> outOfTime{ false };
+
+	TransTable table;
+	uint16 generation = 0;		//!< Bumped for each think(), the table is cleared when it wraps
+
+	Scheduler scheduler;
+};
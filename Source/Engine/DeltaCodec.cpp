@@ -0,0 +1,261 @@
+#include "DeltaCodec.h"
+
+#include <cstring>
+
+namespace{
+
+	const int spawnX = Game::width / 2;				// As Game::spawn()
+
+	void put32(uint8*& out, uint32 value){
+		for (int _b = 0; _b < 4; _b++)
+			out[_b] = (uint8)(value >> (8 * _b));
+		out += 4;
+	}
+
+	uint32 get32(const uint8*& in){
+		uint32 _value = 0;
+		for (int _b = 0; _b < 4; _b++)
+			_value |= (uint32)in[_b] << (8 * _b);
+		in += 4;
+		return _value;
+	}
+
+	uint16 layoutOf(const uint8* block){
+		uint32 _layout = 0;
+		for (int _i = 0; _i < 16; _i++)
+			_layout |= (block[_i] != 0 ? 1u : 0u) << _i;
+		return (uint16)_layout;
+	}
+
+	uint16 rotateLayout(uint8 id, uint16 layout){
+		uint8 _block[16], _rotated[16];
+		for (int _i = 0; _i < 16; _i++)
+			_block[_i] = (layout >> _i) & 1;
+		Game::rotateShape(id, _block, _rotated);
+		return layoutOf(_rotated);
+	}
+
+	// Same test as Game::checkCollision(), the walls, floor + cells above the grid collide
+	bool collides(const BoardState& state, int x, int y){
+		for (int _i = 0; _i < 16; _i++){
+			if ((state.layout & (1 << _i)) == 0)
+				continue;
+			int _row = y - 1 + (_i / 4);
+			int _column = x - 2 + (_i % 4);
+			if (_row < 0 || _row >= Game::height || _column < 0 || _column >= boardColumns ||
+				state.cells[(_row * boardColumns) + _column] != 0)
+				return true;
+		}
+		return false;
+	}
+
+	void spawn(BoardState& state, uint8 id){
+		state.block = id;
+		state.x = (sint8)spawnX;
+		state.y = 0;
+		state.layout = layoutOf(Game::blocks[id % Game::blockCount]);
+	}
+
+	void move(BoardState& state, int rotations, int dx, int dy){
+		for (int _r = 0; _r < rotations; _r++)
+			state.layout = rotateLayout(state.block, state.layout);
+		state.x = (sint8)(state.x + dx);
+		state.y = (sint8)(state.y + dy);
+	}
+
+	// As Game::placeBlock() then newBlock(), without the top out a keyframe covers
+	void lock(BoardState& state, uint8 next){
+		for (int _i = 0; _i < 16; _i++){
+			int _row = state.y - 1 + (_i / 4);
+			int _column = state.x - 2 + (_i % 4);
+			if ((state.layout & (1 << _i)) && _row >= 0 && _row < Game::height && _column >= 0 && _column < boardColumns)
+				state.cells[(_row * boardColumns) + _column] = state.block + 1;
+		}
+
+		// Top to bottom as Game::checkLineComplete(), rows above a removed one move down
+		for (int _y = 0; _y < Game::height; _y++){
+			uint8* _row = &state.cells[_y * boardColumns];
+			bool _full = true;
+			for (int _x = 0; _x < boardColumns && _full; _x++)
+				_full = _row[_x] != 0;
+			if (!_full)
+				continue;
+
+			memmove(&state.cells[boardColumns], &state.cells[0], (size_t)_y * boardColumns);
+			memset(&state.cells[0], 0, boardColumns);
+			state.lines++;
+		}
+
+		state.blocks++;
+		spawn(state, next);
+	}
+
+	// Writes the move from -> to of the falling block, false if the layouts are not a rotation apart
+	bool writeMove(const BoardState& from, const BoardState& to, uint8*& out, BoardState& result){
+		int _rotations = 0;
+		uint16 _layout = from.layout;
+		while (_layout != to.layout){
+			if (++_rotations > 3)
+				return false;
+			_layout = rotateLayout(from.block, _layout);
+		}
+
+		int _dx = to.x - from.x;
+		int _dy = to.y - from.y;
+		if (_rotations == 0 && _dx == 0 && _dy == 0)
+			return true;
+
+		if (_dx >= -3 && _dx <= 3 && _dy >= 0 && _dy <= 3){
+			*out++ = (uint8)(DELTA_MOVE | (_rotations << 5) | ((_dx + 3) << 2) | _dy);
+		}
+		else{
+			*out++ = DELTA_MOVE_FAR;
+			*out++ = (uint8)_rotations;
+			*out++ = (uint8)(sint8)_dx;
+			*out++ = (uint8)(sint8)_dy;
+		}
+		move(result, _rotations, _dx, _dy);
+		return true;
+	}
+
+	// Ops for from -> to into out, returns the end or NULL if ops can not describe it. result is
+	// left as a decoder would have it.
+	uint8* writeOps(const BoardState& from, const BoardState& to, uint8* out, BoardState& result){
+		result = from;
+		if (to.topOuts != from.topOuts)
+			return NULL;
+
+		if (to.blocks == from.blocks){
+			if (to.block != from.block){
+				*out++ = (uint8)(DELTA_SPAWN | to.block);
+				spawn(result, to.block);
+			}
+			return writeMove(result, to, out, result) ? out : NULL;
+		}
+		if (to.blocks != from.blocks + 1)
+			return NULL;
+
+		// Locked where it was, or dropped straight down to where it landed (a hard drop)
+		int _landing = from.y;
+		while (!collides(from, from.x, _landing + 1) && _landing < Game::height)
+			_landing++;
+		BoardState _dropped = from;
+		_dropped.y = (sint8)_landing;
+		if (_landing != from.y && !writeMove(from, _dropped, out, result))
+			return NULL;
+
+		*out++ = (uint8)(DELTA_LOCK | to.block);
+		lock(result, to.block);
+
+		// Anything that happened to the new block in the same step
+		return writeMove(result, to, out, result) ? out : NULL;
+	}
+
+}
+
+void boardState(const Game& game, BoardState& state){
+	const uint8* _grid = game.getGrid();
+	for (int _y = 0; _y < Game::height; _y++)
+		memcpy(&state.cells[_y * boardColumns], &_grid[(_y * Game::width) + 1], boardColumns);
+
+	Vec2 _position = game.getBlockPosition();
+	state.block = game.getCurrentBlockID();
+	state.x = (sint8)_position.x;
+	state.y = (sint8)_position.y;
+	state.layout = layoutOf(game.getCurrentBlock());
+	state.lines = game.getLinesCleared();
+	state.blocks = game.getBlocksPlaced();
+	state.topOuts = game.getTopOuts();
+}
+
+bool operator==(const BoardState& a, const BoardState& b){
+	return a.block == b.block && a.x == b.x && a.y == b.y && a.layout == b.layout && a.lines == b.lines &&
+		a.blocks == b.blocks && a.topOuts == b.topOuts && memcmp(a.cells, b.cells, planeSize) == 0;
+}
+
+size_t deltaOpSize(uint8 first){
+	if (first < 0x80)
+		return 1;
+	if ((first & 0xF8) == DELTA_LOCK || (first & 0xF8) == DELTA_SPAWN)
+		return (first & 7) < Game::blockCount ? 1 : 0;
+	if (first == DELTA_MOVE_FAR)
+		return 4;
+	if (first == DELTA_KEYFRAME)
+		return deltaKeyframeSize;
+	return 0;
+}
+
+size_t DeltaEncoder::writeKeyframe(const BoardState& state, uint8* out){
+	uint8* _out = out;
+	*_out++ = DELTA_KEYFRAME;
+	put32(_out, ++sequence);
+	*_out++ = state.block;
+	*_out++ = (uint8)state.x;
+	*_out++ = (uint8)state.y;
+	*_out++ = (uint8)state.layout;
+	*_out++ = (uint8)(state.layout >> 8);
+	put32(_out, state.lines);
+	put32(_out, state.blocks);
+	put32(_out, state.topOuts);
+	memcpy(_out, state.cells, planeSize);
+
+	last = state;
+	started = true;
+	sinceKeyframe = 0;
+	return deltaKeyframeSize;
+}
+
+size_t DeltaEncoder::encode(const BoardState& state, uint8* out, bool keyframe){
+	if (!started || keyframe || sinceKeyframe >= keyframeInterval)
+		return writeKeyframe(state, out);
+
+	BoardState _result;
+	uint8* _end = writeOps(last, state, out, _result);
+	if (_end == NULL || !(_result == state))
+		return writeKeyframe(state, out);
+
+	// One sequence number per op
+	for (uint8* _op = out; _op < _end; _op += deltaOpSize(*_op)){
+		sequence++;
+		sinceKeyframe++;
+	}
+	last = state;
+	return (size_t)(_end - out);
+}
+
+bool DeltaDecoder::apply(const uint8* op){
+	uint8 _first = op[0];
+	if (deltaOpSize(_first) == 0)
+		return false;
+
+	if (_first == DELTA_KEYFRAME){
+		const uint8* _in = op + 1;
+		sequence = get32(_in);
+		state.block = *_in++;
+		state.x = (sint8)*_in++;
+		state.y = (sint8)*_in++;
+		state.layout = (uint16)(_in[0] | (_in[1] << 8));
+		_in += 2;
+		state.lines = get32(_in);
+		state.blocks = get32(_in);
+		state.topOuts = get32(_in);
+		memcpy(state.cells, _in, planeSize);
+		synced = true;
+		return true;
+	}
+
+	if (!synced)
+		return true;
+
+	if (_first < 0x80)
+		move(state, (_first >> 5) & 3, ((_first >> 2) & 7) - 3, _first & 3);
+	else if (_first == DELTA_MOVE_FAR)
+		move(state, op[1] & 3, (sint8)op[2], (sint8)op[3]);
+	else if ((_first & 0xF8) == DELTA_LOCK)
+		lock(state, _first & 7);
+	else
+		spawn(state, _first & 7);
+
+	sequence++;
+	return true;
+}
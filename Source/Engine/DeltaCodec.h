@@ -0,0 +1,88 @@
+/*Tetris
+Description: Delta codec for a stream of board states, a byte for most updates.
+
+			A stream is a keyframe (the whole state) followed by ops, each turning one state into
+			the next the way the game itself would: move/ rotate the falling block, lock it and
+			spawn the next one. Ops only carry what the rules can not work out, the rows a lock
+			clears follow from the board, the block it spawns is the one thing sent. A move of up
+			to 3 columns/ rows with any rotation is 1 byte, a lock + spawn is 1 byte.
+
+			The encoder decodes what it is about to send and sends a keyframe instead whenever the
+			ops would not give back the state exactly (a top out, a grid a frontend set by hand),
+			so a stream can not drift. Keyframes also go out every keyframeInterval ops so a reader
+			can join or catch up. The length of every op follows from its first byte (deltaOpSize),
+			a stream can be split between ops without decoding it.
+*/
+
+#pragma once
+
+#include "Encoders.h"
+#include "Game.h"
+
+//!< What is sent of a game
+struct BoardState{
+	uint8 cells[planeSize];			//!< Grid values without the walls, row 0 at the top
+	uint8 block;					//!< Falling block id
+	sint8 x;						//!< Falling block pivot, as Game::getBlockPosition()
+	sint8 y;
+	uint16 layout;					//!< Falling block as rotated, bit i set if cell i of the 4x4 is filled
+	uint32 lines;
+	uint32 blocks;
+	uint32 topOuts;
+};
+
+void boardState(const Game& game, BoardState& state);
+bool operator==(const BoardState& a, const BoardState& b);
+
+//!< First byte of an op
+enum DELTA_OP{
+	DELTA_MOVE = 0x00,				//!< 0x00 - 0x7F, rotations << 5 | (dx + 3) << 2 | dy: dx -3 - 3, dy 0 - 3
+	DELTA_LOCK = 0x80,				//!< 0x80 - 0x86, locks the block, clears full rows, spawns block op & 7
+	DELTA_SPAWN = 0x88,				//!< 0x88 - 0x8E, spawns block op & 7 without a lock
+	DELTA_MOVE_FAR = 0xC0,			//!< Then rotations, dx, dy as bytes
+	DELTA_KEYFRAME = 0xFF			//!< Then the sequence (uint32) + the whole state
+};
+
+const size_t deltaKeyframeSize = 1 + 4 + 17 + planeSize;
+const size_t deltaMaxUpdate = deltaKeyframeSize;	//!< Most encode() writes for one state
+
+//!< Bytes in the op starting with first, 0 if it is not one
+size_t deltaOpSize(uint8 first);
+
+class DeltaEncoder{
+public:
+	explicit DeltaEncoder(uint32 keyframeInterval = 4096) : keyframeInterval(keyframeInterval) {}
+
+	//!< Writes the ops taking the last state encoded to state into out (deltaMaxUpdate bytes),
+	//!< returns how many bytes. A keyframe is written for the first state, every keyframeInterval
+	//!< ops, any change ops can not describe, or when keyframe is set.
+	size_t encode(const BoardState& state, uint8* out, bool keyframe = false);
+
+	//!< Ops written so far, the sequence of the last one
+	uint32 getSequence() const { return sequence; }
+
+private:
+	size_t writeKeyframe(const BoardState& state, uint8* out);
+
+	BoardState last = {};
+	uint32 keyframeInterval;
+	uint32 sequence = 0;
+	uint32 sinceKeyframe = 0;
+	bool started = false;
+};
+
+class DeltaDecoder{
+public:
+	//!< Applies the op at op (deltaOpSize(op[0]) bytes). Returns false if it is not an op. Ops
+	//!< before the first keyframe are skipped.
+	bool apply(const uint8* op);
+
+	bool isSynced() const { return synced; }
+	uint32 getSequence() const { return sequence; }		//!< Of the last op applied
+	const BoardState& getState() const { return state; }
+
+private:
+	BoardState state = {};
+	uint32 sequence = 0;
+	bool synced = false;
+};
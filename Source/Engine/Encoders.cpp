@@ -0,0 +1,158 @@
+#include "Encoders.h"
+
+#include <cstdlib>
+#include <cstring>
+
+static_assert(boardColumns == 10, "Rows are read as 8 + 2 cells");
+
+namespace{
+
+	const uint32 fullRow = (1u << boardColumns) - 1;
+
+	// Each byte of cells becomes 0x80 if it was not 0, else 0
+	uint64 filledHighBits(uint64 cells){
+		return (((cells & 0x7F7F7F7F7F7F7F7Full) + 0x7F7F7F7F7F7F7F7Full) | cells) & 0x8080808080808080ull;
+	}
+
+	uint32 bitCount(uint32 value){
+		value = value - ((value >> 1) & 0x55555555u);
+		value = (value & 0x33333333u) + ((value >> 2) & 0x33333333u);
+		return (((value + (value >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24;
+	}
+
+	// Cells of the falling block inside the playing area, as rows
+	void blockRows(const Game& game, uint16* rows){
+		memset(rows, 0, sizeof(uint16) * Game::height);
+
+		const uint8* _block = game.getCurrentBlock();
+		Vec2 _position = game.getBlockPosition();
+		for (int y = 0; y < 4; y++){
+			for (int x = 0; x < 4; x++){
+				// Same offsets as Game::checkCollision(), the playing area starts at grid column 1
+				int _row = _position.y - 1 + y;
+				int _column = _position.x - 2 + x;
+				if (_block[(y * 4) + x] && _row >= 0 && _row < Game::height && _column >= 0 && _column < boardColumns)
+					rows[_row] |= (uint16)(1u << _column);
+			}
+		}
+	}
+
+	template <typename T>
+	void expandRows(const uint16* rows, T* plane){
+		for (int _y = 0; _y < Game::height; _y++){
+			for (int _x = 0; _x < boardColumns; _x++)
+				plane[(_y * boardColumns) + _x] = (T)((rows[_y] >> _x) & 1);
+		}
+	}
+
+}
+
+void encodeRows(const Game& game, uint16* rows){
+	const uint8* _grid = game.getGrid();
+	for (int _y = 0; _y < Game::height; _y++){
+		// Columns 0 - 7 and 2 - 9, overlapping so both reads stay inside the row
+		const uint8* _row = &_grid[(_y * Game::width) + 1];
+		uint64 _left, _right;
+		memcpy(&_left, _row, sizeof(_left));
+		memcpy(&_right, _row + 2, sizeof(_right));
+
+		// Multiplying gathers the high bit of each byte into the top byte, byte 0 lowest
+		uint32 _low = (uint32)((filledHighBits(_left) * 0x0002040810204081ull) >> 56);
+		uint32 _high = (uint32)((filledHighBits(_right) * 0x0002040810204081ull) >> 56);
+		rows[_y] = (uint16)(_low | (_high << 2));
+	}
+}
+
+void encodeBoard(const Game& game, uint8* plane){
+	const uint8* _grid = game.getGrid();
+	for (int _y = 0; _y < Game::height; _y++){
+		const uint8* _row = &_grid[(_y * Game::width) + 1];
+		uint8* _out = &plane[_y * boardColumns];
+
+		uint64 _cells;
+		memcpy(&_cells, _row, sizeof(_cells));
+		uint64 _filled = filledHighBits(_cells) >> 7;
+		memcpy(_out, &_filled, sizeof(_filled));
+		_out[8] = _row[8] != 0;
+		_out[9] = _row[9] != 0;
+	}
+}
+
+void encodePlanes(const Game& game, uint8* planes){
+	encodeBoard(game, planes);
+
+	uint16 _block[Game::height];
+	blockRows(game, _block);
+	expandRows(_block, planes + planeSize);
+}
+
+void encodePlanes(const Game& game, float* planes){
+	uint16 _rows[Game::height];
+	encodeRows(game, _rows);
+	expandRows(_rows, planes);
+
+	blockRows(game, _rows);
+	expandRows(_rows, planes + planeSize);
+}
+
+void encodeFeatures(const Game& game, float* features){
+	uint16 _rows[Game::height];
+	encodeRows(game, _rows);
+	encodeFeatures(_rows, features);
+}
+
+void encodeFeatures(const uint16* rows, float* features){
+	int _heights[boardColumns];
+	for (int _x = 0; _x < boardColumns; _x++)
+		_heights[_x] = 0;
+
+	uint32 _above = 0;			// Columns with a filled cell in an earlier row
+	uint32 _holes = 0;
+	uint32 _rowTransitions = 0;
+	uint32 _columnTransitions = 0;
+	uint32 _previous = 0;		// Open sky above the top row
+
+	for (int _y = 0; _y < Game::height; _y++){
+		uint32 _row = rows[_y];
+
+		// Columns whose first filled cell is in this row
+		uint32 _tops = _row & ~_above;
+		for (int _x = 0; _tops != 0; _x++, _tops >>= 1){
+			if (_tops & 1)
+				_heights[_x] = Game::height - _y;
+		}
+
+		_holes += bitCount(~_row & _above & fullRow);
+
+		// Walls either side as filled bits
+		uint32 _walled = (_row << 1) | 1u | (1u << (boardColumns + 1));
+		_rowTransitions += bitCount((_walled ^ (_walled >> 1)) & ((1u << (boardColumns + 1)) - 1));
+		_columnTransitions += bitCount(_row ^ _previous);
+
+		_above |= _row;
+		_previous = _row;
+	}
+	_columnTransitions += bitCount(_previous ^ fullRow);
+
+	int _maxHeight = 0, _bumpiness = 0, _wells = 0;
+	for (int _x = 0; _x < boardColumns; _x++){
+		features[ENCODED_HEIGHTS + _x] = (float)_heights[_x];
+		_maxHeight = _heights[_x] > _maxHeight ? _heights[_x] : _maxHeight;
+
+		if (_x + 1 < boardColumns)
+			_bumpiness += abs(_heights[_x] - _heights[_x + 1]);
+
+		int _left = _x > 0 ? _heights[_x - 1] : Game::height;
+		int _right = _x + 1 < boardColumns ? _heights[_x + 1] : Game::height;
+		int _depth = (_left < _right ? _left : _right) - _heights[_x];
+		if (_depth > 0)
+			_wells += _depth;
+	}
+
+	features[ENCODED_HOLES] = (float)_holes;
+	features[ENCODED_ROW_TRANSITIONS] = (float)_rowTransitions;
+	features[ENCODED_COLUMN_TRANSITIONS] = (float)_columnTransitions;
+	features[ENCODED_MAX_HEIGHT] = (float)_maxHeight;
+	features[ENCODED_BUMPINESS] = (float)_bumpiness;
+	features[ENCODED_WELLS] = (float)_wells;
+}
@@ -0,0 +1,42 @@
+/*Tetris
+Description: Encodes a game for learning, written into buffers the caller owns.
+
+			Three forms of the playing area (walls left out, row 0 at the top): rows with one bit
+			per cell; planes with one value per cell, the board then the falling block; and a
+			vector of hand made features. Rows are read from the byte grid 8 cells at a time,
+			the features are worked out from the rows a whole row at a time.
+*/
+
+#pragma once
+
+#include "Game.h"
+
+const int boardColumns = Game::width - 2;
+const int planeSize = boardColumns * Game::height;
+const int planeCount = 2;		//!< Board, falling block
+
+//!< Offsets into the feature vector
+enum ENCODED_FEATURE{
+	ENCODED_HEIGHTS = 0,							//!< boardColumns column heights, left first
+	ENCODED_HOLES = boardColumns,					//!< Empty cells with a filled cell somewhere above
+	ENCODED_ROW_TRANSITIONS,						//!< Filled/ empty changes along the rows, walls count as filled
+	ENCODED_COLUMN_TRANSITIONS,						//!< Filled/ empty changes down the columns, the floor counts as filled
+	ENCODED_MAX_HEIGHT,
+	ENCODED_BUMPINESS,								//!< Sum of the height differences between neighbouring columns
+	ENCODED_WELLS,									//!< Sum of how far each column is below both neighbours, walls are full height
+	ENCODED_FEATURE_COUNT
+};
+
+//!< Game::height rows, bit x set if column x is filled
+void encodeRows(const Game& game, uint16* rows);
+
+//!< planeSize values, the board plane alone
+void encodeBoard(const Game& game, uint8* plane);
+
+//!< planeCount * planeSize values, 1 filled, 0 empty
+void encodePlanes(const Game& game, uint8* planes);
+void encodePlanes(const Game& game, float* planes);
+
+//!< ENCODED_FEATURE_COUNT values
+void encodeFeatures(const Game& game, float* features);
+void encodeFeatures(const uint16* rows, float* features);
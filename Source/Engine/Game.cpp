@@ -0,0 +1,380 @@
+#include "Game.h"
+#include "Trace.h"
+
+#include <cstring>
+
+//!< Array to hold blocks 
+//!< Rather than come up with an eloborate algorithm I've stored the rotations within the arrays
+//!< 7 blocks, 4 animations, 4x4 grid 
+const uint8 Game::blocks[Game::blockCount][16] = {
+	
+  { 1, 1, 0, 0, 
+	1, 1, 0, 0,
+	0, 0, 0, 0,
+	0, 0, 0, 0 },
+	
+	{0, 0, 0, 0,
+	 1, 1, 1, 1,
+	 0, 0, 0, 0,
+	 0, 0, 0, 0},
+
+	{1, 0, 0, 0,
+	 1, 1, 1, 0,
+	 0, 0, 0, 0,
+	 0, 0, 0, 0 },
+
+	{0, 0, 1, 0,
+	 1, 1, 1, 0,
+	 0, 0, 0, 0,
+	 0, 0, 0, 0 },
+
+	{0, 0, 0, 0,
+	 1, 1, 1, 0,
+	 0, 1, 0, 0,
+	 0, 0, 0, 0 },
+
+	{0, 1, 1, 0,
+	 1, 1, 0, 0,
+	 0, 0, 0, 0,
+	 0, 0, 0, 0 },
+
+	{1, 1, 0, 0,
+	 0, 1, 1, 0,
+	 0, 0, 0, 0,
+	 0, 0, 0, 0 }
+
+};
+
+Game::Game(uint64 seed){
+	reset(seed);
+}
+
+void Game::reset(uint64 seed){
+	//Set grid to naught 
+	memset(grid, 0, sizeof(grid));
+
+	// Set bricks at side 
+	for (int _gridY = 0; _gridY < height; _gridY++){
+		grid[_gridY*width] = wallCell; 
+		grid[(_gridY*width) + (width - 1)] = wallCell; 
+	}
+
+	memset(currentBlock, 0, sizeof(currentBlock));
+	blockPosition = Vec2(0, 0);
+	currentBlockType = 0;
+	currentBlockID = 0;
+	blockDropMS = blockDropDefault;
+	blockDropedElapsed = 0;
+
+	// splitmix64 so nearby seeds give unrelated sequences, xorshift must not start at 0
+	uint64 _z = seed + 0x9E3779B97F4A7C15ULL;
+	_z = (_z ^ (_z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	_z = (_z ^ (_z >> 27)) * 0x94D049BB133111EBULL;
+	randomState = (_z ^ (_z >> 31)) | 1;
+
+	for (int _p = 0; _p < previewSize; _p++)
+		preview[_p] = (uint8)(nextRandom() % blockCount);
+
+	gameOver = false;
+	topOuts = 0;
+	linesCleared = 0;
+	blocksPlaced = 0;
+}
+
+void Game::setGrid(const uint8* cells){
+	memcpy(grid, cells, sizeof(grid));
+}
+
+uint32 Game::nextRandom(){
+	randomState ^= randomState >> 12;
+	randomState ^= randomState << 25;
+	randomState ^= randomState >> 27;
+	return (uint32)((randomState * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+void Game::setCurrentBlock(const uint8* layout, Vec2 position){
+	memcpy(currentBlock, layout, sizeof(currentBlock));
+	blockPosition = position;
+}
+
+// Randomonly select a block/ reset position to the top of the grid.
+void Game::newBlock(){
+	uint8 _block = preview[0];
+	memmove(preview, preview + 1, previewSize - 1);
+	preview[previewSize - 1] = (uint8)(nextRandom() % blockCount);
+	spawn(_block);
+}
+
+void Game::spawn(uint8 id){
+	currentBlockType = (0x1 << (id));
+	currentBlockID = id; 
+
+	//copys the block to the current block array 
+	memcpy(currentBlock, blocks[id], sizeof(currentBlock));
+
+	blockPosition = Vec2(width/2, 0);
+
+	// If start position obstructed, only the rows inside the grid can be
+	for (int y = 1; y < 4; y++){
+		for (int x = 0; x < 4; x++){
+			if (currentBlock[(y * 4) + x] && grid[((y - 1) * width) + blockPosition.x - 1 + x]){
+				topOut();
+				return;
+			}
+		}
+	}
+}
+
+void Game::topOut(){
+	topOuts++;
+	if (!endless){
+		gameOver = true;
+		return;
+	}
+
+	// Clear grid 
+	for (int _y = 0; _y < height; _y++)
+		memset(&grid[(_y * width) + 1], 0, width - 2);
+}
+
+bool Game::checkCollision(const uint8* block, Vec2 position) const{
+
+	for (int y = 0; y < 4; y++){
+		for (int x = 0; x < 4; x++){
+			if (block[(y * 4) + x]){
+				int _gridX = position.x - 1 + x; 
+				int _gridY = position.y - 1 + y;
+
+				if (_gridX < 0 || _gridY < 0 || _gridX >= width || _gridY >= height){
+					return true; 
+				}
+
+				if (grid[(_gridY * width) + _gridX]){
+					return true; 
+				}
+			}
+		}
+	}
+
+	return false; 
+}
+
+// Rotates a block layout. 
+void Game::rotateShape(uint8 id, const uint8* layout, uint8* rotated){
+	//rather than doing anything too elobarate 
+	//square is not to rotate// line is speical case, everything else treated as a 3x3 matrix 
+	uint8 _type = (uint8)(0x1 << id);
+
+	memcpy(rotated, layout, 16);
+
+	// Is square block 
+	if (_type & BLOCK_TYPE::BLOCK1){
+		return; 
+	}
+
+	// Is line block 
+	if (_type & BLOCK_TYPE::BLOCK2){
+		// Hard coded solution is simpler 
+		if (layout[4] != 0){
+			memset(rotated, 0, 16);
+			rotated[1] = 1; 
+			rotated[5] = 1;
+			rotated[9] = 1;
+			rotated[13] = 1;
+		}
+		else{
+			memcpy(rotated, blocks[1], 16);
+		}
+	
+	}
+	else if (_type >= BLOCK_TYPE::BLOCK6){ // Z blocks
+		
+		if (layout[0] == 0 && layout[1] == 0){
+			for (int i = 0; i < 3; i++){
+				for (int p = 0; p < 3; p++)
+					rotated[(p * 4) + i] = layout[((2 - i) * 4) + p];
+			}
+		}
+		else{
+			for (int i = 0; i < 3; i++){
+				for (int p = 0; p < 3; p++)
+					rotated[(p * 4) + i] = layout[((i) * 4) + (2 - p)];
+			}
+		}
+	}
+	else{	//!< every other block.
+		for (int i = 0; i < 3; i++){
+			for (int p = 0; p < 3; p++)
+				rotated[(p * 4) + i] = layout[((2-i) * 4) + p];
+		}
+	}
+}
+
+// Rotates the current block. 
+bool Game::rotateBlock(){
+	// Is square block 
+	if (currentBlockType & BLOCK_TYPE::BLOCK1){
+		return false; 
+	}
+
+	uint8 _rotated[16];
+	rotateShape(currentBlockID, currentBlock, _rotated);
+
+	// If collision after rotating, keep the previous layout
+	if (checkCollision(_rotated, blockPosition))
+		return false;
+
+	memcpy(currentBlock, _rotated, sizeof(currentBlock));
+	return true;
+}
+
+bool Game::moveLeft(){
+	if (checkCollision(currentBlock, Vec2(blockPosition.x - 1, blockPosition.y)))
+		return false;
+	blockPosition.x -= 1;
+	return true;
+}
+
+bool Game::moveRight(){
+	if (checkCollision(currentBlock, Vec2(blockPosition.x + 1, blockPosition.y)))
+		return false;
+	blockPosition.x += 1;
+	return true;
+}
+
+void Game::removeLine(int y){
+
+	// Move all rows above down by 1 
+	for (int _y = y; _y > 0; _y--)
+		memcpy(&grid[(_y * width) + 1], &grid[((_y - 1) * width) + 1], width - 2);
+
+	// Nothing above the top row, it comes in empty 
+	memset(&grid[1], 0, width - 2);
+}
+
+void Game::addGarbage(int lines, int hole){
+	if (lines <= 0)
+		return;
+	if (lines > height)
+		lines = height;
+
+	// Anything in the rows about to go off the top
+	bool _pushedOut = false;
+	for (int _y = 0; _y < lines && !_pushedOut; _y++){
+		for (int _x = 1; _x < width - 1; _x++){
+			if (grid[(_y * width) + _x]){
+				_pushedOut = true;
+				break;
+			}
+		}
+	}
+
+	// Walls are the same on every row so whole rows can move
+	memmove(&grid[0], &grid[lines * width], (height - lines) * width);
+	for (int _y = height - lines; _y < height; _y++){
+		memset(&grid[(_y * width) + 1], garbageCell, width - 2);
+		grid[(_y * width) + 1 + hole] = 0;
+	}
+
+	// The falling block rides up with the stack rather than ending up inside it
+	while (blockPosition.y > 0 && checkCollision(currentBlock, blockPosition))
+		blockPosition.y--;
+
+	bool _blocked = false;
+	for (int y = 1; y < 4 && blockPosition.y == 0; y++){
+		for (int x = 0; x < 4; x++){
+			if (currentBlock[(y * 4) + x] && grid[((y - 1) * width) + blockPosition.x - 1 + x])
+				_blocked = true;
+		}
+	}
+
+	if (_pushedOut || _blocked)
+		topOut();
+}
+
+int Game::checkLineComplete(){
+	TRACE_SCOPE("checkLineComplete");
+	int _removed = 0;
+
+	//Accounts for brick outline, top to bottom so rows moved down by a removal have already been checked 
+	for (int _y = 0; _y < height; _y++){
+		bool lineComplete = true; 
+		for (int _x = 1; _x < width-1; _x++){
+			if (grid[(_y * width) + _x] == 0){
+				lineComplete = false; 
+				break; 
+			}
+		}
+
+		if (lineComplete){
+			removeLine(_y);
+			_removed++;
+		}
+	}
+
+	linesCleared += _removed;
+	return _removed;
+}
+
+bool Game::lockBlock(){
+	bool _inside = true;
+
+	// Assign values in grid, note block pivot == 1,1 
+	for (int y = 0; y < 4; y++){
+		for (int x = 0; x < 4; x++){
+			if (currentBlock[(4 * y) + x] == 0)
+				continue;
+
+			int _gridY = blockPosition.y - 1 + y;
+			if (_gridY < 0){
+				_inside = false;
+				continue;
+			}
+			grid[(_gridY * width) + blockPosition.x - 1 + x] = currentBlockID + 1;
+		}
+	}
+
+	blocksPlaced++;
+	return _inside;
+}
+
+bool Game::placeBlock(){
+	if (!lockBlock())
+		return false;
+
+	//Checks if any lines are complete. 
+	checkLineComplete(); 
+	return true;
+}
+
+bool Game::dropDown(){
+	TRACE_SCOPE("dropDown");
+	if (gameOver)
+		return false;
+
+	if (!checkCollision(currentBlock, Vec2(blockPosition.x, blockPosition.y + 1))){
+		blockPosition.y++;
+		return false;
+	}
+
+	// Locked above the top of the grid 
+	if (!placeBlock()){
+		topOut();
+		if (gameOver)
+			return true;
+	}
+
+	newBlock();
+	return true;
+}
+
+void Game::update(float tickMS){
+	if (gameOver)
+		return;
+
+	blockDropedElapsed += tickMS; 
+	if (blockDropedElapsed > blockDropMS){
+		blockDropedElapsed = 0; 
+		dropDown(); 
+	}
+}
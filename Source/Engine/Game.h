@@ -0,0 +1,152 @@
+/*Tetris
+Description: The rules of the game, a single self contained instance with no SDL/ GL.
+
+			Everything a game needs lives in the class (grid, falling block, drop timer, random
+			number generator) so any number of games can run side by side, on any thread, and a 
+			game can be copied to try moves out. Frontends feed input through the move functions
+			and step time with update(), then read the state back to draw it.
+*/
+
+#pragma once
+
+#include "../Common.h"
+
+//Block types enumeration 
+/**
+	Standard game of tetris consists of 7 blocks
+	Naught == Empty 
+*/
+	//Inspiring names... 
+enum BLOCK_TYPE{
+	EMPTY = 0x0,
+	BLOCK1 = 0x1 << 0, // Square 
+	BLOCK2 = 0x1 << 1, // Line 
+	BLOCK3 = 0x1 << 2, 
+	BLOCK4 = 0x1 << 3, 
+	BLOCK5 = 0x1 << 4, 
+	BLOCK6 = 0x1 << 5,
+	BLOCK7 = 0x1 << 6, 
+	WALL = 0x1 << 7
+};
+
+class Game{
+public:
+	static const int width = 12;			//!< Including the wall either side
+	static const int height = 22;
+	static const int cellCount = width * height;
+	static const int blockCount = 7;
+	static const uint8 wallCell = 8;		//!< Grid value of the walls (tile 7)
+	static const uint8 garbageCell = wallCell;	//!< Grid value of garbage rows, drawn as the walls
+	static const int previewSize = 5;		//!< Upcoming blocks known in advance
+
+	//!< Shapes of the 7 blocks as spawned, 4x4 with the pivot at 1, 1
+	static const uint8 blocks[blockCount][16];
+
+	//!< Writes the layout block id (0 - 6) turns into when rotated, ignoring collisions
+	static void rotateShape(uint8 id, const uint8* layout, uint8* rotated);
+
+	explicit Game(uint64 seed = 1);
+
+	//!< Empty grid with walls, new random sequence + preview, no falling block until newBlock()
+	void reset(uint64 seed);
+
+	//!< Replaces the grid (cellCount values, walls included), the falling block is left as it is
+	void setGrid(const uint8* cells);
+
+	//!< Moves the falling block to position with the given layout (one of its rotations)
+	void setCurrentBlock(const uint8* layout, Vec2 position);
+
+	//!< Next block from the preview at the top of the grid, a new random block joins the preview
+	void newBlock();
+
+	//!< Puts the given block (0 - 6) at the top of the grid, as newBlock() but without the random pick
+	void spawn(uint8 id);
+
+	//!< Input, each returns true if the block moved
+	bool moveLeft();
+	bool moveRight();
+	bool rotateBlock();
+
+	//!< Moves the block down 1, or locks it into the grid, clears lines and spawns the next block.
+	//!< Returns true if the block locked.
+	bool dropDown();
+
+	//!< Locks the block where it is and removes complete lines without spawning the next block.
+	//!< Returns false if part of the block was above the grid, which tops the game out.
+	bool placeBlock();
+
+	//!< Returns true if the current block is colliding with anything in grid.
+	bool checkCollision() const { return checkCollision(currentBlock, blockPosition); }
+
+	//!< Returns true if block would collide at position, cells above the grid count as colliding
+	bool checkCollision(const uint8* block, Vec2 position) const;
+
+	//!< Removes every complete line, returns how many were removed
+	int checkLineComplete();
+
+	//Remove a line by a given y coordinate, everything above moves down by 1
+	void removeLine(int y);
+
+	//!< Pushes the stack up lines rows and fills the bottom with garbage, empty only in column hole
+	//!< (0 - width - 3). Tops the game out if filled cells are pushed off the top.
+	void addGarbage(int lines, int hole);
+
+	//!< Advances the drop timer by tickMS, dropping the block when it runs out
+	void update(float tickMS);
+
+	//!< Drops at the faster rate while set 
+	void setSoftDrop(bool enabled) { blockDropMS = enabled ? blockDropFaster : blockDropDefault; }
+
+	//!< Endless games (the default) clear the grid and carry on when they top out, otherwise the game ends
+	void setEndless(bool enabled) { endless = enabled; }
+
+	const uint8* getGrid() const { return grid; }
+	const uint8* getCurrentBlock() const { return currentBlock; }
+	Vec2 getBlockPosition() const { return blockPosition; }
+	uint8 getCurrentBlockID() const { return currentBlockID; }
+
+	//!< Block id that will spawn i + 1 blocks from now, i < previewSize
+	uint8 getPreview(int i) const { return preview[i]; }
+
+	float getDropElapsed() const { return blockDropedElapsed; }		//!< Time on the drop timer since the last drop
+	uint16 getDropMS() const { return blockDropMS; }				//!< Drop interval, shorter while soft dropping
+	uint64 getRandomState() const { return randomState; }			//!< Generator the preview is filled from
+
+	bool isGameOver() const { return gameOver; }
+	uint32 getTopOuts() const { return topOuts; }
+	uint32 getLinesCleared() const { return linesCleared; }
+	uint32 getBlocksPlaced() const { return blocksPlaced; }
+
+private:
+	// Ends the game, or in endless mode clears the grid to carry on
+	void topOut();
+
+	// Writes the current block into the grid, returns false if part of it was above the grid
+	bool lockBlock();
+
+	// xorshift64*, small enough that copying a game stays cheap
+	uint32 nextRandom();
+
+	//!< Array to hold grid data
+	uint8 grid[cellCount];
+
+	uint8 currentBlock[16];
+	Vec2 blockPosition = Vec2(0, 0);
+	uint8 currentBlockType = 0; 
+	uint8 currentBlockID = 0;
+
+	//How fast the blocks drop ms
+	uint16 blockDropDefault = 600; // Level 1 value 
+	uint16 blockDropFaster = 30;
+	uint16 blockDropMS = 600; 
+	float blockDropedElapsed = 0; 
+
+	uint64 randomState = 1;
+	uint8 preview[previewSize];
+
+	bool endless = true;
+	bool gameOver = false;
+	uint32 topOuts = 0;
+	uint32 linesCleared = 0;
+	uint32 blocksPlaced = 0;
+};
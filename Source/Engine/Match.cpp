@@ -0,0 +1,96 @@
+#include "Match.h"
+
+#include <cmath>
+
+void ThinkHistogram::add(float ms){
+	double _us = ms * 1000.0;
+	int _bucket = _us <= 1.0 ? 0 : (int)(std::log2(_us) * 4.0);
+	buckets[_bucket < bucketCount ? _bucket : bucketCount - 1]++;
+}
+
+void ThinkHistogram::merge(const ThinkHistogram& other){
+	for (int _b = 0; _b < bucketCount; _b++)
+		buckets[_b] += other.buckets[_b];
+}
+
+uint64 ThinkHistogram::count() const{
+	uint64 _count = 0;
+	for (int _b = 0; _b < bucketCount; _b++)
+		_count += buckets[_b];
+	return _count;
+}
+
+float ThinkHistogram::percentile(double fraction) const{
+	uint64 _target = (uint64)(fraction * count());
+	uint64 _seen = 0;
+	for (int _b = 0; _b < bucketCount; _b++){
+		_seen += buckets[_b];
+		if (_seen > _target)
+			return (float)(std::pow(2.0, (_b + 1) / 4.0) / 1000.0);	// Upper edge of the bucket
+	}
+	return 0;
+}
+
+GameRecord playGame(Bot& bot, uint64 seed, uint32 maxBlocks, ThinkHistogram* histogram, std::vector<ReplayPlacement>* replay){
+	GameRecord _record;
+	_record.seed = seed;
+	bool _stuck = false;
+
+	Game _game(seed);
+	_game.setEndless(false);
+	_game.newBlock();
+
+	if (replay != NULL)
+		replay->clear();
+
+	while (_game.getBlocksPlaced() < maxBlocks){
+		uint32 _lines = _game.getLinesCleared();
+		uint32 _blocks = _game.getBlocksPlaced();
+		uint8 _block = _game.getCurrentBlockID();
+		bool _placed = bot.play(_game);
+
+		float _think = bot.getLastThinkMS();
+		_record.thinkMS += _think;
+		_record.maxThinkMS = _think > _record.maxThinkMS ? _think : _record.maxThinkMS;
+		if (histogram != NULL)
+			histogram->add(_think);
+
+		uint32 _cleared = _game.getLinesCleared() - _lines;
+		if (_cleared > 0)
+			_record.clears[(_cleared > 4 ? 4 : _cleared) - 1]++;
+
+		if (replay != NULL && _game.getBlocksPlaced() != _blocks){
+			const Placement& _placement = bot.getLastPlacement();
+			ReplayPlacement _entry = {};
+			_entry.type = REPLAY_PLACEMENT;
+			_entry.block = _block;
+			_entry.x = _placement.x;
+			_entry.y = _placement.y;
+			_entry.rotation = _placement.rotation;
+			_entry.lines = (uint8)_cleared;
+			_entry.thinkMS = _think;
+			_entry.index = (uint32)replay->size();
+			replay->push_back(_entry);
+		}
+
+		if (!_placed || _game.isGameOver()){
+			_stuck = !_placed;
+			break;
+		}
+	}
+
+	_record.blocks = _game.getBlocksPlaced();
+	_record.lines = _game.getLinesCleared();
+	_record.toppedOut = _game.isGameOver() || _stuck;
+	return _record;
+}
+
+ReplayGame replayGame(const GameRecord& record, uint32 placementCount){
+	ReplayGame _game = {};
+	_game.type = REPLAY_GAME;
+	_game.rules = record.toppedOut ? REPLAY_TOPPED_OUT : 0;		// playGame() never plays endless
+	_game.previewSize = Game::previewSize;
+	_game.placementCount = placementCount;
+	_game.seed = record.seed;
+	return _game;
+}
@@ -0,0 +1,44 @@
+/*Tetris
+Description: Plays a whole game with a bot and records how it went, for tournaments + tuning.
+*/
+
+#pragma once
+
+#include <vector>
+
+#include "Game.h"
+#include "Bot.h"
+#include "Replay.h"
+
+//!< Outcome of one game
+struct GameRecord{
+	uint64 seed = 0;
+	uint32 blocks = 0;			//!< Blocks placed before topping out or reaching the limit
+	uint32 lines = 0;
+	uint32 clears[4] = {};		//!< Placements that cleared 1, 2, 3 + 4 lines
+	bool toppedOut = false;
+	double thinkMS = 0;			//!< Total bot think time
+	float maxThinkMS = 0;
+};
+
+//!< Think time histogram, 4 buckets per doubling from 1us, merged by adding
+struct ThinkHistogram{
+	static const int bucketCount = 96;
+	uint64 buckets[bucketCount] = {};
+
+	void add(float ms);
+	void merge(const ThinkHistogram& other);
+
+	//!< Think time in ms below which fraction (0 - 1) of the samples fall
+	float percentile(double fraction) const;
+	uint64 count() const;
+};
+
+//!< Plays the game with seed until it tops out or maxBlocks have been placed. 
+//!< Each block's think time is added to histogram when given.
+//!< replay, when given, is filled with the game's placements for a ReplayWriter.
+GameRecord playGame(Bot& bot, uint64 seed, uint32 maxBlocks, ThinkHistogram* histogram = NULL,
+	std::vector<ReplayPlacement>* replay = NULL);
+
+//!< The ReplayGame that starts record's game in a replay file
+ReplayGame replayGame(const GameRecord& record, uint32 placementCount);
@@ -0,0 +1,197 @@
+#include "MoveGen.h"
+
+#include <cstring>
+
+namespace{
+
+	inline bool testBit(const uint64* bits, int index){
+		return (bits[index >> 6] >> (index & 63)) & 1;
+	}
+
+	inline void setBit(uint64* bits, int index){
+		bits[index >> 6] |= 1ULL << (index & 63);
+	}
+
+}
+
+const MoveGen::BlockShapes& MoveGen::shapes(uint8 id){
+	// Built once, on first use
+	struct AllShapes{
+		BlockShapes blocks[Game::blockCount];
+
+		AllShapes(){
+			memset(blocks, 0, sizeof(blocks));
+			for (int _b = 0; _b < Game::blockCount; _b++){
+				BlockShapes& _shapes = blocks[_b];
+				memcpy(_shapes.layouts[0], Game::blocks[_b], 16);
+				_shapes.count = 1;
+
+				// Follow rotateShape() until a layout comes round again
+				for (int _r = 0; _r < _shapes.count; _r++){
+					uint8 _rotated[16];
+					Game::rotateShape((uint8)_b, _shapes.layouts[_r], _rotated);
+
+					int _next = 0;
+					while (_next < _shapes.count && memcmp(_shapes.layouts[_next], _rotated, 16) != 0)
+						_next++;
+					if (_next == _shapes.count && _shapes.count < maxRotations){
+						memcpy(_shapes.layouts[_next], _rotated, 16);
+						_shapes.count++;
+					}
+					_shapes.next[_r] = (uint8)(_next < _shapes.count ? _next : _r);
+				}
+
+				for (int _r = 0; _r < _shapes.count; _r++){
+					const uint8* _layout = _shapes.layouts[_r];
+					int _minX = 4, _minY = 4;
+					for (int y = 0; y < 4; y++){
+						for (int x = 0; x < 4; x++){
+							if (_layout[(y * 4) + x]){
+								_shapes.rows[_r][y] |= 1u << x;
+								_minX = x < _minX ? x : _minX;
+								_minY = y < _minY ? y : _minY;
+							}
+						}
+					}
+					_shapes.offsetX[_r] = (sint8)_minX;
+					_shapes.offsetY[_r] = (sint8)_minY;
+
+					// Same cells once both are shifted to the top left corner
+					_shapes.canonical[_r] = (uint8)_r;
+					for (int _o = 0; _o < _r; _o++){
+						bool _same = true;
+						for (int y = 0; y < 4 && _same; y++){
+							int _ya = y + _minY, _yb = y + _shapes.offsetY[_o];
+							uint32 _a = _ya < 4 ? _shapes.rows[_r][_ya] >> _minX : 0;
+							uint32 _b = _yb < 4 ? _shapes.rows[_o][_yb] >> _shapes.offsetX[_o] : 0;
+							_same = _a == _b;
+						}
+						if (_same){
+							_shapes.canonical[_r] = _shapes.canonical[_o];
+							break;
+						}
+					}
+				}
+			}
+		}
+	};
+
+	static const AllShapes _all;
+	return _all.blocks[id];
+}
+
+bool MoveGen::collides(int rotation, int x, int y) const{
+	const uint32* _piece = blockShapes->rows[rotation];
+	const uint32* _rows = &rows[y + 3];
+	int _shift = x + 3;
+
+	return ((_piece[0] << _shift) & _rows[0]) | ((_piece[1] << _shift) & _rows[1]) |
+		   ((_piece[2] << _shift) & _rows[2]) | ((_piece[3] << _shift) & _rows[3]);
+}
+
+bool MoveGen::visit(int rotation, int x, int y, int parent, uint8 move){
+	int _index = stateIndex(rotation, x, y);
+	if (testBit(visited, _index))
+		return false;
+	setBit(visited, _index);
+
+	Node& _node = nodes[nodeCount++];
+	_node.x = (sint8)x;
+	_node.y = (sint8)y;
+	_node.rotation = (uint8)rotation;
+	_node.move = move;
+	_node.parent = (sint16)parent;
+	return true;
+}
+
+int MoveGen::generate(const Game& game){
+	blockID = game.getCurrentBlockID();
+	blockShapes = &shapes(blockID);
+
+	// Grid as row bits, column x is bit x + 4 
+	const uint8* _grid = game.getGrid();
+	const uint32 _outside = ~(((1u << Game::width) - 1) << 4);
+	for (int _y = 0; _y < 4; _y++){
+		rows[_y] = 0xFFFFFFFF;
+		rows[Game::height + 4 + _y] = 0xFFFFFFFF;
+	}
+	for (int _y = 0; _y < Game::height; _y++){
+		uint32 _row = _outside;
+		const uint8* _cells = &_grid[_y * Game::width];
+		for (int _x = 0; _x < Game::width; _x++)
+			_row |= (uint32)(_cells[_x] != 0) << (_x + 4);
+		rows[_y + 4] = _row;
+	}
+
+	memset(visited, 0, sizeof(visited));
+	memset(placed, 0, sizeof(placed));
+	nodeCount = 0;
+	placementCount = 0;
+
+	// Rotation state of the block as it is now
+	int _rotation = 0;
+	while (_rotation < blockShapes->count && memcmp(blockShapes->layouts[_rotation], game.getCurrentBlock(), 16) != 0)
+		_rotation++;
+	if (_rotation == blockShapes->count)
+		return 0;
+
+	Vec2 _position = game.getBlockPosition();
+	visit(_rotation, _position.x, _position.y, -1, MOVE_DOWN);
+
+	// nodes doubles as the queue, every node is expanded once in the order it was found
+	for (int _n = 0; _n < nodeCount; _n++){
+		const Node _node = nodes[_n];
+		int x = _node.x, y = _node.y, r = _node.rotation;
+
+		if (!collides(r, x - 1, y))
+			visit(r, x - 1, y, _n, MOVE_LEFT);
+		if (!collides(r, x + 1, y))
+			visit(r, x + 1, y, _n, MOVE_RIGHT);
+
+		int _next = blockShapes->next[r];
+		if (_next != r && !collides(_next, x, y))
+			visit(_next, x, y, _n, MOVE_ROTATE);
+
+		if (!collides(r, x, y + 1)){
+			visit(r, x, y + 1, _n, MOVE_DOWN);
+		}
+		else{
+			// Locks here, once per set of cells
+			int _cells = stateIndex(blockShapes->canonical[r], x + blockShapes->offsetX[r], y + blockShapes->offsetY[r]);
+			if (!testBit(placed, _cells)){
+				setBit(placed, _cells);
+				Placement& _placement = placements[placementCount++];
+				_placement.x = (sint8)x;
+				_placement.y = (sint8)y;
+				_placement.rotation = (uint8)r;
+				_placement.node = (uint16)_n;
+			}
+		}
+	}
+
+	return placementCount;
+}
+
+const uint8* MoveGen::layout(int i) const{
+	return blockShapes->layouts[placements[i].rotation];
+}
+
+int MoveGen::path(int i, uint8* moves, int maxMoves) const{
+	int _length = 0;
+	for (int _n = placements[i].node; nodes[_n].parent >= 0; _n = nodes[_n].parent)
+		_length++;
+	if (_length > maxMoves)
+		return -1;
+
+	// Walk back from the placement, filling from the end
+	int _at = _length;
+	for (int _n = placements[i].node; nodes[_n].parent >= 0; _n = nodes[_n].parent)
+		moves[--_at] = nodes[_n].move;
+	return _length;
+}
+
+bool MoveGen::apply(int i, Game& game) const{
+	const Placement& _placement = placements[i];
+	game.setCurrentBlock(layout(i), Vec2(_placement.x, _placement.y));
+	return game.placeBlock();
+}
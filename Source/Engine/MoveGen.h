@@ -0,0 +1,98 @@
+/*Tetris
+Description: Finds every place the falling block can lock, with the inputs that get it there.
+
+			Breadth first search over (x, y, rotation) states using the same rules as Game: moves
+			and rotations fail if the block would collide at its new position, the block locks
+			when it can not move down. Rotations come from Game::rotateShape, collisions are tested
+			against the grid as one bitmask per row, a visited bit per state keeps each state to a
+			single visit. Placements that fill the same cells are only returned once, with the
+			shortest input path to them. Nothing is allocated per search.
+*/
+
+#pragma once
+
+#include "Game.h"
+
+//!< Inputs a path is made of, the same as calling the Game function of the same name
+enum MOVE{
+	MOVE_LEFT,
+	MOVE_RIGHT,
+	MOVE_ROTATE,
+	MOVE_DOWN
+};
+
+//!< Where the falling block locks
+struct Placement{
+	sint8 x;			//!< Block position (pivot) when it locks
+	sint8 y;
+	uint8 rotation;		//!< Rotation state, index of the layout in the block's rotation cycle
+	uint16 node;		//!< Search node it was found at, see MoveGen::path()
+};
+
+class MoveGen{
+public:
+	static const int maxRotations = 4;
+	static const int stateWidth = 16;		//!< Block x from -2 to 13
+	static const int stateHeight = 24;		//!< Block y from 0 to 23
+	static const int stateCount = maxRotations * stateWidth * stateHeight;
+	static const int maxPath = 64;
+
+	//!< Finds the placements of game's falling block from where it is now, returns how many
+	int generate(const Game& game);
+
+	int count() const { return placementCount; }
+	const Placement& placement(int i) const { return placements[i]; }
+
+	//!< Layout of the falling block at placement i
+	const uint8* layout(int i) const;
+
+	//!< Writes the inputs from the searched state to placement i (not including the final lock,
+	//!< one more MOVE_DOWN), returns how many or -1 if there are more than maxMoves
+	int path(int i, uint8* moves, int maxMoves) const;
+
+	//!< Locks game's falling block at placement i (Game::placeBlock), returns false if it topped out
+	bool apply(int i, Game& game) const;
+
+private:
+	struct Node{
+		sint8 x;
+		sint8 y;
+		uint8 rotation;
+		uint8 move;			//!< Move that reached this node from parent
+		sint16 parent;		//!< -1 for the start node
+	};
+
+	// Rotation states of a block, built once from Game::rotateShape
+	struct BlockShapes{
+		int count;								//!< Distinct layouts in the rotation cycle
+		uint8 layouts[maxRotations][16];
+		uint8 next[maxRotations];				//!< Rotation state rotateShape() goes to
+		uint32 rows[maxRotations][4];			//!< Row bits of each layout, bit p = column p
+		uint8 canonical[maxRotations];			//!< Layouts the same up to a shift share a canonical index
+		sint8 offsetX[maxRotations];			//!< Shift from the canonical layout
+		sint8 offsetY[maxRotations];
+	};
+	static const BlockShapes& shapes(uint8 id);
+
+	bool collides(int rotation, int x, int y) const;
+	bool visit(int rotation, int x, int y, int parent, uint8 move);
+
+	static int stateIndex(int rotation, int x, int y){
+		return (rotation * stateHeight + y) * stateWidth + x + 2;
+	}
+
+	// Grid rows, 4 filled columns either side, 4 filled rows above (above the grid collides) + below
+	uint32 rows[Game::height + 8];
+
+	const BlockShapes* blockShapes = NULL;
+	uint8 blockID = 0;
+
+	uint64 visited[stateCount / 64];
+	uint64 placed[stateCount / 64];
+
+	Node nodes[stateCount];
+	int nodeCount = 0;
+
+	Placement placements[stateCount];
+	int placementCount = 0;
+};
@@ -0,0 +1,165 @@
+#include "Replay.h"
+
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace{
+
+	const uint8 replayMagic[4] = { 'R', 'P', 'L', 0 };
+	const size_t recordSize = sizeof(ReplayPlacement);
+
+}
+
+bool ReplayWriter::open(const char* path){
+	close();
+	file = fopen(path, "wb");
+	if (file == NULL)
+		return false;
+
+	ReplayHeader _header;
+	memcpy(_header.magic, replayMagic, sizeof(_header.magic));
+	_header.version = replayVersion;
+	_header.recordSize = (uint32)recordSize;
+	_header.reserved = 0;
+	failed = fwrite(&_header, sizeof(_header), 1, file) != 1;
+	return !failed;
+}
+
+bool ReplayWriter::write(const ReplayGame& game, const ReplayPlacement* placements){
+	std::lock_guard<std::mutex> _lock(mutex);
+	if (file == NULL || failed)
+		return false;
+
+	failed = fwrite(&game, sizeof(game), 1, file) != 1 ||
+		(game.placementCount > 0 && fwrite(placements, recordSize, game.placementCount, file) != game.placementCount);
+	return !failed;
+}
+
+bool ReplayWriter::close(){
+	std::lock_guard<std::mutex> _lock(mutex);
+	if (file == NULL)
+		return !failed;
+
+	failed = fclose(file) != 0 || failed;
+	file = NULL;
+	return !failed;
+}
+
+bool ReplayReader::open(const char* path){
+	close();
+
+	const void* _view = NULL;
+	size_t _size = 0;
+#ifdef _WIN32
+	HANDLE _file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (_file == INVALID_HANDLE_VALUE)
+		return false;
+	fileHandle = _file;
+
+	LARGE_INTEGER _fileSize;
+	if (!GetFileSizeEx(_file, &_fileSize) || (uint64)_fileSize.QuadPart > (uint64)(size_t)-1){
+		close();
+		return false;
+	}
+	_size = (size_t)_fileSize.QuadPart;
+
+	if (_size >= sizeof(ReplayHeader)){
+		mapping = CreateFileMappingA(_file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (mapping != NULL)
+			_view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	}
+#else
+	int _file = ::open(path, O_RDONLY);
+	if (_file < 0)
+		return false;
+
+	struct stat _stat;
+	if (fstat(_file, &_stat) == 0 && (size_t)_stat.st_size >= sizeof(ReplayHeader)){
+		_size = (size_t)_stat.st_size;
+		_view = mmap(NULL, _size, PROT_READ, MAP_SHARED, _file, 0);
+		if (_view == MAP_FAILED)
+			_view = NULL;
+	}
+	::close(_file);		// The mapping keeps the file open
+
+	// Scans read front to back, let the kernel read well ahead of them
+	if (_view != NULL)
+		madvise((void*)_view, _size, MADV_SEQUENTIAL);
+#endif
+
+	if (_view == NULL){
+		close();
+		return false;
+	}
+	records = (const uint8*)_view;
+	mappedSize = _size;
+	recordCount = _size / recordSize;
+
+	const ReplayHeader& _header = *(const ReplayHeader*)records;
+	if (memcmp(_header.magic, replayMagic, sizeof(replayMagic)) != 0 || _header.version != replayVersion ||
+		_header.recordSize != recordSize){
+		close();
+		return false;
+	}
+	return true;
+}
+
+void ReplayReader::close(){
+#ifdef _WIN32
+	if (records != NULL)
+		UnmapViewOfFile(records);
+	if (mapping != NULL)
+		CloseHandle(mapping);
+	if (fileHandle != NULL)
+		CloseHandle(fileHandle);
+	mapping = NULL;
+	fileHandle = NULL;
+#else
+	if (records != NULL)
+		munmap((void*)records, mappedSize);
+#endif
+	records = NULL;
+	recordCount = 0;
+	mappedSize = 0;
+}
+
+size_t ReplayReader::gameAt(size_t record) const{
+	while (record < recordCount && records[record * recordSize] != REPLAY_GAME)
+		record++;
+	return record;
+}
+
+void ReplayReader::shard(int index, int count, size_t& begin, size_t& end) const{
+	if (recordCount <= 1 || count <= 0){
+		begin = end = recordCount;
+		return;
+	}
+
+	// Even split of the records after the header, each edge moved on to the next game
+	size_t _games = recordCount - 1;
+	begin = gameAt(1 + (size_t)((uint64)_games * index / count));
+	end = index + 1 >= count ? recordCount : gameAt(1 + (size_t)((uint64)_games * (index + 1) / count));
+}
+
+bool ReplayReader::nextGame(size_t& record, size_t end, ReplayGameView& view) const{
+	record = gameAt(record);
+	if (record >= end)
+		return false;
+
+	const ReplayGame* _game = (const ReplayGame*)&records[record * recordSize];
+	if (_game->placementCount >= recordCount - record)
+		return false;		// Cut short
+
+	view.game = _game;
+	view.placements = (const ReplayPlacement*)(_game + 1);
+	record += 1 + (size_t)_game->placementCount;
+	return true;
+}
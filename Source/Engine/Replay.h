@@ -0,0 +1,138 @@
+/*Tetris
+Description: Replay corpus, whole games kept as fixed size records that are read straight from a mapped file.
+
+			Every record is 16 bytes with its type in the first byte. A file is a ReplayHeader
+			followed by games, each a ReplayGame (seed + rules) then one ReplayPlacement per block
+			placed. Nothing is variable length or compressed, so a reader maps the file and walks
+			the records in place: no parsing, no copies, and the game a record belongs to can be
+			found from any record by looking for the next ReplayGame. That is how a corpus is
+			sharded, each shard starts at the first game on or after an even split of the records,
+			so any number of threads scan their own contiguous part of the file.
+
+			Records are written little endian, as the machines that make + read them are. Games are
+			written whole, so games played on many threads never interleave. A file cut short by
+			a crash loses only its last game, the reader stops at the first game that does not fit.
+*/
+
+#pragma once
+
+#include <cstdio>
+#include <mutex>
+
+#include "../Common.h"
+
+const uint32 replayVersion = 1;
+
+//!< First byte of every record
+enum REPLAY_RECORD{
+	REPLAY_HEADER = 0x52,		//!< 'R', of the "RPL" magic
+	REPLAY_GAME = 0x01,
+	REPLAY_PLACEMENT = 0x02
+};
+
+//!< ReplayGame::rules flags
+enum REPLAY_RULES{
+	REPLAY_ENDLESS = 1 << 0,		//!< Topping out cleared the grid and play carried on
+	REPLAY_TOPPED_OUT = 1 << 1		//!< The game ended by topping out, not at its block limit
+};
+
+//!< First record of a file
+struct ReplayHeader{
+	uint8 magic[4];				//!< "RPL\0"
+	uint32 version;				//!< replayVersion
+	uint32 recordSize;			//!< sizeof(ReplayPlacement)
+	uint32 reserved;
+};
+
+//!< Starts a game, placementCount placements follow it
+struct ReplayGame{
+	uint8 type;					//!< REPLAY_GAME
+	uint8 rules;				//!< REPLAY_RULES
+	uint8 previewSize;			//!< Blocks the player could see coming
+	uint8 reserved;
+	uint32 placementCount;
+	uint64 seed;				//!< Game(seed) deals the same blocks again
+};
+
+//!< One block locked into the grid
+struct ReplayPlacement{
+	uint8 type;					//!< REPLAY_PLACEMENT
+	uint8 block;				//!< Id 0 - 6
+	sint8 x;					//!< Block position (pivot) when it locked
+	sint8 y;
+	uint8 rotation;				//!< See Placement
+	uint8 lines;				//!< Cleared by this placement
+	uint16 reserved;
+	float thinkMS;				//!< Time the player took to choose it
+	uint32 index;				//!< Placements before this one in the game
+};
+
+static_assert(sizeof(ReplayHeader) == 16 && sizeof(ReplayGame) == 16 && sizeof(ReplayPlacement) == 16, "Replay records are 16 bytes");
+
+//!< Appends games to a replay file, safe to call from any number of threads
+class ReplayWriter{
+public:
+	ReplayWriter() {}
+	~ReplayWriter() { close(); }
+
+	//!< Starts a new file at path, returns false if it could not be made
+	bool open(const char* path);
+
+	//!< Adds game and its game.placementCount placements in one piece
+	bool write(const ReplayGame& game, const ReplayPlacement* placements);
+
+	//!< Returns false if any write failed
+	bool close();
+
+private:
+	ReplayWriter(const ReplayWriter&) = delete;
+	ReplayWriter& operator=(const ReplayWriter&) = delete;
+
+	FILE* file = NULL;
+	bool failed = false;
+	std::mutex mutex;
+};
+
+//!< A game inside a mapped file, valid while the reader is open
+struct ReplayGameView{
+	const ReplayGame* game;
+	const ReplayPlacement* placements;		//!< game->placementCount of them
+};
+
+//!< Maps a replay file read only and hands out its games
+class ReplayReader{
+public:
+	ReplayReader() {}
+	~ReplayReader() { close(); }
+
+	//!< Maps path, returns false if it is not a replay file of this version
+	bool open(const char* path);
+	void close();
+
+	//!< Records in the file, the header included
+	size_t getRecordCount() const { return recordCount; }
+	size_t getFileSize() const { return mappedSize; }
+
+	//!< Records [begin, end) of shard index of count, both on game boundaries. The shards
+	//!< cover every game once between them.
+	void shard(int index, int count, size_t& begin, size_t& end) const;
+
+	//!< Fills view with the game at record and moves record past it. Returns false once record
+	//!< reaches end, or at a game that runs past the end of the file.
+	bool nextGame(size_t& record, size_t end, ReplayGameView& view) const;
+
+private:
+	ReplayReader(const ReplayReader&) = delete;
+	ReplayReader& operator=(const ReplayReader&) = delete;
+
+	// First game record on or after record, recordCount if there is none
+	size_t gameAt(size_t record) const;
+
+	const uint8* records = NULL;
+	size_t recordCount = 0;
+	size_t mappedSize = 0;
+#ifdef _WIN32
+	void* fileHandle = NULL;
+	void* mapping = NULL;
+#endif
+};
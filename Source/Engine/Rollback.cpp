@@ -0,0 +1,104 @@
+#include "Rollback.h"
+
+#include <cstring>
+
+RollbackSession::RollbackSession(uint64 seed, int localPlayer, uint32 _inputDelay)
+	: match(seed), localPlayer(localPlayer), inputDelay(_inputDelay < maxInputDelay ? _inputDelay : maxInputDelay), localEnd(inputDelay){
+	memset(checksums, 0, sizeof(checksums));
+	memset(localInputs, 0, sizeof(localInputs));		// The first inputDelay frames have no input
+	memset(remoteInputs, 0, sizeof(remoteInputs));
+	memset(predicted, 0, sizeof(predicted));
+	for (uint32 _f = 0; _f < historySize; _f++)
+		remoteFrames[_f] = noFrame;
+}
+
+uint8 RollbackSession::predict(uint32 frame) const{
+	if (remoteFrames[frame % historySize] == frame)
+		return remoteInputs[frame % historySize];
+	if (remoteEnd == 0)
+		return 0;
+
+	// Taps are one frame, a soft drop is held
+	return remoteInputs[(remoteEnd - 1) % historySize] & VERSUS_SOFT_DROP;
+}
+
+void RollbackSession::play(uint32 frame){
+	uint32 _slot = frame % historySize;
+	snapshots[_slot] = match;
+
+	uint8 _inputs[VersusMatch::players];
+	_inputs[localPlayer] = localInputs[_slot];
+	_inputs[1 - localPlayer] = predicted[_slot] = predict(frame);
+	match.step(_inputs);
+	checksums[_slot] = match.checksum();
+}
+
+void RollbackSession::advance(uint8 input){
+	uint32 _frame = getFrame();
+	localInputs[(_frame + inputDelay) % historySize] = input & VERSUS_INPUT_MASK;
+	localEnd = _frame + inputDelay + 1;
+
+	synchronize();
+	play(_frame);
+}
+
+void RollbackSession::synchronize(){
+	uint32 _frame = getFrame();
+	if (rollbackFrom < _frame){
+		uint32 _depth = _frame - rollbackFrom;
+		match = snapshots[rollbackFrom % historySize];
+		for (uint32 _f = rollbackFrom; _f < _frame; _f++)
+			play(_f);
+
+		rollbacks++;
+		framesReplayed += _depth;
+		if (_depth > maxRollback)
+			maxRollback = _depth;
+	}
+	rollbackFrom = noFrame;
+}
+
+void RollbackSession::addRemoteInput(uint32 frame, uint8 input){
+	// Outside the window a slot could be reused in, the peer sends it again later
+	if (frame < remoteEnd || frame >= remoteEnd + (historySize / 2))
+		return;
+
+	uint32 _slot = frame % historySize;
+	if (remoteFrames[_slot] == frame)
+		return;
+	remoteFrames[_slot] = frame;
+	remoteInputs[_slot] = input & VERSUS_INPUT_MASK;
+
+	if (frame < getFrame() && predicted[_slot] != remoteInputs[_slot] && frame < rollbackFrom)
+		rollbackFrom = frame;
+
+	while (remoteFrames[remoteEnd % historySize] == remoteEnd)
+		remoteEnd++;
+}
+
+void RollbackSession::addRemoteStatus(uint32 frame, int advantage){
+	if (remoteFrame == noFrame || frame > remoteFrame){
+		remoteFrame = frame;
+		remoteAdvantage = advantage;
+	}
+}
+
+int RollbackSession::framesAhead() const{
+	return (getLocalAdvantage() - remoteAdvantage) / 2;
+}
+
+uint32 RollbackSession::getConfirmedEnd() const{
+	uint32 _end = getFrame();
+	if (remoteEnd < _end)
+		_end = remoteEnd;
+	if (rollbackFrom < _end)
+		_end = rollbackFrom;
+	return _end;
+}
+
+bool RollbackSession::confirmedChecksum(uint32 frame, uint64& checksum) const{
+	if (frame >= getConfirmedEnd() || frame + historySize <= getFrame())
+		return false;
+	checksum = checksums[frame % historySize];
+	return true;
+}
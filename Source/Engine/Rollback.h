@@ -0,0 +1,108 @@
+/*Tetris
+Description: Rollback netcode for a VersusMatch, in the style of GGPO.
+
+			Each machine plays every frame as soon as its own input is in, it never waits for the
+			other player's. Until the remote input for a frame arrives it is predicted: taps (move,
+			rotate, drop) are predicted not to happen, a held soft drop to carry on. Before each
+			frame is played the match is copied into a ring of snapshots. When the real input for
+			a frame already played turns out to differ from the prediction, the next advance()
+			restores the snapshot from before that frame and plays every frame since again with
+			what is now known, all inside the one call, then plays the new frame. The player only
+			ever sees the corrected state.
+
+			Local input is delayed by inputDelay frames, so on a LAN most remote input arrives
+			before it is needed and rollbacks stay short. advance() is refused (canAdvance()) once
+			maxPrediction frames have been played past the last remote input, so a stalled peer
+			can not push the rollback past the snapshots kept.
+
+			The session has no networking of its own. A transport sends getLocalInput() frames the
+			peer has not acknowledged, hands what arrives to addRemoteInput()/ addRemoteStatus(),
+			and can compare confirmedChecksum() of both sides to catch a desync.
+*/
+
+#pragma once
+
+#include "Versus.h"
+
+class RollbackSession{
+public:
+	static const uint32 historySize = 128;		//!< Frames of snapshots + inputs kept, a power of 2
+	static const uint32 maxPrediction = 30;		//!< Frames played past the last remote input before advance waits
+	static const uint32 noFrame = 0xFFFFFFFF;
+
+	//!< Longest input delay, a replay still finds every input it needs in the history + the peer
+	//!< is never sent a frame past it before the ones it is waiting on
+	static const uint32 maxInputDelay = historySize - maxPrediction - 1;
+
+	//!< inputDelay is clamped to maxInputDelay
+	RollbackSession(uint64 seed, int localPlayer, uint32 _inputDelay = 2);
+
+	//!< False while too far ahead of the remote input, call advance() once more has arrived
+	bool canAdvance() const { return getFrame() < remoteEnd + maxPrediction; }
+
+	//!< Queues input as the local input inputDelay frames from now, replays any frames played with a
+	//!< wrong prediction, then plays the next frame
+	void advance(uint8 input);
+
+	//!< Replays frames played with a wrong prediction now rather than at the next advance(), for
+	//!< when no more frames are coming (stalled, or the match is over)
+	void synchronize();
+
+	//!< Remote input for frame, in any order, repeats + frames already confirmed are ignored
+	void addRemoteInput(uint32 frame, uint8 input);
+
+	//!< The peer's frame + how far it was ahead of us as it saw it, for framesAhead()
+	void addRemoteStatus(uint32 frame, int advantage);
+
+	//!< Frames this side should wait to let the peer catch up, GGPO's time sync. Both sides see the
+	//!< same latency so the difference of the two advantages is what is left of a real lead.
+	int framesAhead() const;
+
+	//!< How far this side's frame is ahead of the peer's last reported frame
+	int getLocalAdvantage() const { return remoteFrame == noFrame ? 0 : (int)getFrame() - (int)remoteFrame; }
+
+	const VersusMatch& getMatch() const { return match; }
+	uint32 getFrame() const { return match.getFrame(); }		//!< Next frame to play
+	int getLocalPlayer() const { return localPlayer; }
+
+	uint32 getLocalInputEnd() const { return localEnd; }		//!< Local input known for frames before this
+	uint8 getLocalInput(uint32 frame) const { return localInputs[frame % historySize]; }
+	uint32 getRemoteInputEnd() const { return remoteEnd; }		//!< Remote input known for every frame before this
+
+	//!< Frames before this were played with both real inputs, nothing can roll them back
+	uint32 getConfirmedEnd() const;
+
+	//!< VersusMatch::checksum() after frame, false unless frame is confirmed + still kept
+	bool confirmedChecksum(uint32 frame, uint64& checksum) const;
+
+	uint32 getRollbacks() const { return rollbacks; }
+	uint64 getFramesReplayed() const { return framesReplayed; }
+	uint32 getMaxRollback() const { return maxRollback; }		//!< Most frames replayed by one advance()
+
+private:
+	// Plays frame (the match's next) with the inputs known or predicted for it
+	void play(uint32 frame);
+	uint8 predict(uint32 frame) const;
+
+	VersusMatch match;
+	VersusMatch snapshots[historySize];		//!< Match before frame i % historySize was played
+	uint64 checksums[historySize];			//!< Match after frame i % historySize was played
+
+	uint8 localInputs[historySize];
+	uint8 remoteInputs[historySize];
+	uint32 remoteFrames[historySize];		//!< Frame remoteInputs holds, noFrame for none
+	uint8 predicted[historySize];			//!< Remote input frame was last played with
+
+	int localPlayer;
+	uint32 inputDelay;
+	uint32 localEnd;
+	uint32 remoteEnd = 0;
+	uint32 rollbackFrom = noFrame;			//!< First frame played with a wrong prediction
+
+	uint32 remoteFrame = noFrame;
+	int remoteAdvantage = 0;
+
+	uint32 rollbacks = 0;
+	uint64 framesReplayed = 0;
+	uint32 maxRollback = 0;
+};
@@ -0,0 +1,192 @@
+#include "Scheduler.h"
+
+#include <algorithm>
+
+Scheduler::Deque::Deque(){
+	for (int _i = 0; _i < dequeSize; _i++)
+		tasks[_i].store(NULL, std::memory_order_relaxed);
+}
+
+bool Scheduler::Deque::push(Task* task){
+	sint64 _bottom = bottom.load(std::memory_order_relaxed);
+	sint64 _top = top.load(std::memory_order_acquire);
+	if (_bottom - _top >= dequeSize)
+		return false;
+
+	tasks[_bottom & (dequeSize - 1)].store(task, std::memory_order_relaxed);
+	bottom.store(_bottom + 1, std::memory_order_release);	// Publishes the task's data to thieves
+	return true;
+}
+
+Scheduler::Task* Scheduler::Deque::pop(){
+	sint64 _bottom = bottom.load(std::memory_order_relaxed) - 1;
+	bottom.store(_bottom, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	sint64 _top = top.load(std::memory_order_relaxed);
+
+	if (_top > _bottom){
+		// Empty
+		bottom.store(_bottom + 1, std::memory_order_relaxed);
+		return NULL;
+	}
+
+	Task* _task = tasks[_bottom & (dequeSize - 1)].load(std::memory_order_relaxed);
+	if (_top == _bottom){
+		// Last task, a thief may be taking it too
+		if (!top.compare_exchange_strong(_top, _top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			_task = NULL;
+		bottom.store(_bottom + 1, std::memory_order_relaxed);
+	}
+	return _task;
+}
+
+Scheduler::Task* Scheduler::Deque::steal(){
+	sint64 _top = top.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	sint64 _bottom = bottom.load(std::memory_order_acquire);
+	if (_top >= _bottom)
+		return NULL;
+
+	Task* _task = tasks[_top & (dequeSize - 1)].load(std::memory_order_relaxed);
+	if (!top.compare_exchange_strong(_top, _top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+		return NULL;	// Lost to the owner or another thief
+	return _task;
+}
+
+Scheduler::Scheduler(int _threads){
+	if (_threads <= 0)
+		_threads = (int)std::thread::hardware_concurrency();
+	_threads = std::max(_threads, 1);
+
+	for (int _w = 0; _w < _threads; _w++){
+		workers.push_back(new Worker());
+		workers[_w]->random = 0x9E3779B9u * (_w + 1);
+	}
+
+	// The thread calling wait() is worker 0
+	for (int _w = 1; _w < _threads; _w++)
+		threads.push_back(std::thread(&Scheduler::workerLoop, this, _w));
+}
+
+Scheduler::~Scheduler(){
+	{
+		std::lock_guard<std::mutex> _lock(mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	for (size_t _t = 0; _t < threads.size(); _t++)
+		threads[_t].join();
+
+	for (size_t _w = 0; _w < workers.size(); _w++){
+		for (size_t _t = 0; _t < workers[_w]->allocated.size(); _t++)
+			delete workers[_w]->allocated[_t];
+		delete workers[_w];
+	}
+}
+
+Scheduler::Task* Scheduler::allocate(int worker){
+	Worker& _worker = *workers[worker];
+	Task* _task = _worker.freeTasks;
+	if (_task != NULL){
+		_worker.freeTasks = _task->nextFree;
+		return _task;
+	}
+
+	_task = new Task();
+	_worker.allocated.push_back(_task);
+	return _task;
+}
+
+void Scheduler::spawn(Group& group, TaskFunc func, const void* data, int size, int worker){
+	Task* _task = allocate(worker);
+	_task->func = func;
+	_task->group = &group;
+	memcpy(_task->data, data, size);
+	group.pending.fetch_add(1, std::memory_order_relaxed);
+
+	queued.fetch_add(1);
+	if (!workers[worker]->deque.push(_task)){
+		queued.fetch_sub(1);
+		run(_task, worker);
+		return;
+	}
+
+	// Taking the lock means a worker about to sleep has either seen the task or is waiting
+	if (sleeping.load() > 0){
+		{
+			std::lock_guard<std::mutex> _lock(mutex);
+		}
+		wake.notify_one();
+	}
+}
+
+void Scheduler::run(Task* task, int worker){
+	task->func(*this, worker, task->data);
+
+	// Back onto the free list of whoever ran it, tasks move between workers but are only
+	// ever touched by one at a time
+	Group* _group = task->group;
+	Worker& _worker = *workers[worker];
+	task->nextFree = _worker.freeTasks;
+	_worker.freeTasks = task;
+
+	_group->pending.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+Scheduler::Task* Scheduler::find(int worker){
+	Worker& _worker = *workers[worker];
+	Task* _task = _worker.deque.pop();
+
+	if (_task == NULL && workers.size() > 1){
+		// Steal, starting from a random victim so thieves spread out
+		_worker.random ^= _worker.random << 13;
+		_worker.random ^= _worker.random >> 17;
+		_worker.random ^= _worker.random << 5;
+
+		int _count = (int)workers.size();
+		int _start = (int)(_worker.random % _count);
+		for (int _v = 0; _v < _count && _task == NULL; _v++){
+			int _victim = (_start + _v) % _count;
+			if (_victim != worker)
+				_task = workers[_victim]->deque.steal();
+		}
+	}
+
+	if (_task != NULL)
+		queued.fetch_sub(1);
+	return _task;
+}
+
+void Scheduler::wait(Group& group, int worker){
+	while (group.pending.load(std::memory_order_acquire) != 0){
+		Task* _task = find(worker);
+		if (_task != NULL)
+			run(_task, worker);
+		else
+			std::this_thread::yield();	// The rest are running on other workers
+	}
+}
+
+void Scheduler::workerLoop(int worker){
+	int _idle = 0;
+	while (!stopping.load(std::memory_order_relaxed)){
+		Task* _task = find(worker);
+		if (_task != NULL){
+			run(_task, worker);
+			_idle = 0;
+			continue;
+		}
+
+		// Spin a little first, searches spawn in bursts
+		if (++_idle < 64){
+			std::this_thread::yield();
+			continue;
+		}
+
+		std::unique_lock<std::mutex> _lock(mutex);
+		sleeping.fetch_add(1);
+		wake.wait(_lock, [&]{ return stopping.load() || queued.load() > 0; });
+		sleeping.fetch_sub(1);
+		_idle = 0;
+	}
+}
@@ -0,0 +1,102 @@
+/*Tetris
+Description: Work stealing task scheduler for the searches.
+
+			Every worker has its own deque of tasks (Chase-Lev), it pushes + pops its own work at
+			the bottom and other workers steal from the top when they run out, so an uneven tree
+			of tasks still keeps every thread busy. A task carries a copy of its data (a game
+			state for example) inside itself so it does not depend on its parent still being
+			around. Tasks come from per worker free lists, nothing is allocated once warmed up.
+
+			The thread that calls wait() works as worker 0, only one outside thread may use a
+			scheduler at a time.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "../Common.h"
+
+class Scheduler{
+public:
+	static const int taskDataSize = 512;	//!< Largest data a task can carry
+	static const int dequeSize = 4096;		//!< Tasks a worker can have queued, more run straight away
+
+	//!< Called with the worker running it and the task's copy of the data it was spawned with
+	typedef void (*TaskFunc)(Scheduler& scheduler, int worker, void* data);
+
+	//!< Tasks to wait for, children can be spawned into the same group
+	struct Group{
+		std::atomic<int> pending{ 0 };
+	};
+
+	//!< threads includes the calling thread, 0 for one per core
+	explicit Scheduler(int threads = 0);
+	~Scheduler();
+
+	int workerCount() const { return (int)workers.size(); }
+
+	//!< Queues func with a copy of data on worker's deque, worker is the one spawning
+	void spawn(Group& group, TaskFunc func, const void* data, int size, int worker);
+
+	template <typename T>
+	void spawn(Group& group, TaskFunc func, const T& data, int worker){
+		static_assert(std::is_trivially_copyable<T>::value, "Task data is copied with memcpy");
+		static_assert(sizeof(T) <= taskDataSize, "Task data is too large");
+		static_assert(alignof(T) <= alignof(uint64), "Task data is only 8 byte aligned");
+		spawn(group, func, &data, (int)sizeof(T), worker);
+	}
+
+	//!< Runs (and steals) tasks until every task in group has finished
+	void wait(Group& group, int worker);
+
+private:
+	struct Task{
+		TaskFunc func;
+		Group* group;
+		Task* nextFree;
+		uint64 data[taskDataSize / sizeof(uint64)];
+	};
+
+	//!< Chase-Lev deque, the owner pushes + pops at bottom, thieves take from top
+	class Deque{
+	public:
+		Deque();
+		bool push(Task* task);		//!< Owner, false when full
+		Task* pop();				//!< Owner
+		Task* steal();				//!< Any thread
+	private:
+		std::atomic<sint64> top{ 0 };
+		char padding[64];				//!< Keeps thieves off the owner's cache line
+		std::atomic<sint64> bottom{ 0 };
+		std::atomic<Task*> tasks[dequeSize];
+	};
+
+	struct Worker{
+		Deque deque;
+		Task* freeTasks = NULL;			//!< Owner only
+		std::vector<Task*> allocated;	//!< Owner only, deleted with the scheduler
+		uint32 random = 1;				//!< Victim choice
+	};
+
+	Task* allocate(int worker);
+	void run(Task* task, int worker);
+	Task* find(int worker);
+	void workerLoop(int worker);
+
+	std::vector<Worker*> workers;
+	std::vector<std::thread> threads;
+
+	// Idle workers sleep until something is queued
+	std::atomic<int> queued{ 0 };
+	std::atomic<int> sleeping{ 0 };
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::atomic<bool> stopping{ false };
+};
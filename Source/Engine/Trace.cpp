@@ -0,0 +1,126 @@
+#include "Trace.h"
+
+#ifdef TETRIS_TRACE
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+
+thread_local TraceRing* traceRing = NULL;
+
+namespace{
+
+	typedef std::chrono::steady_clock Clock;
+
+	const Clock::time_point traceStart = Clock::now();
+
+	// Every ring ever made, rings outlive their threads so a flush still shows them
+	std::mutex ringsLock;
+	std::vector<TraceRing*> rings;
+
+	uint64 traceNow(){
+		return (uint64)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - traceStart).count();
+	}
+
+	struct Copied{
+		const char* name;
+		uint64 time;
+	};
+
+	// The ring's events still intact once copied, oldest first
+	void copyRing(const TraceRing& ring, std::vector<Copied>& out){
+		uint64 _head = ring.head.load(std::memory_order_acquire);
+		uint64 _first = _head > TraceRing::size ? _head - TraceRing::size : 0;
+
+		out.clear();
+		for (uint64 _i = _first; _i < _head; _i++){
+			const TraceRing::Event& _event = ring.events[_i & (TraceRing::size - 1)];
+			Copied _copied = { _event.name.load(std::memory_order_relaxed), _event.time.load(std::memory_order_relaxed) };
+			out.push_back(_copied);
+		}
+
+		// Pairs with the fence in record(), anything the owner started writing over is dropped
+		std::atomic_thread_fence(std::memory_order_acquire);
+		uint64 _writing = ring.writing.load(std::memory_order_relaxed);
+		if (_writing > _first + TraceRing::size){
+			size_t _lost = (size_t)(_writing - (_first + TraceRing::size));
+			out.erase(out.begin(), out.begin() + (_lost < out.size() ? _lost : out.size()));
+		}
+	}
+
+}
+
+void TraceRing::record(const char* name, bool end){
+	uint64 _index = head.load(std::memory_order_relaxed);
+	writing.store(_index + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	Event& _event = events[_index & (size - 1)];
+	_event.name.store(name, std::memory_order_relaxed);
+	_event.time.store(traceNow() | (end ? endBit : 0), std::memory_order_relaxed);
+	head.store(_index + 1, std::memory_order_release);
+}
+
+void traceThread(const char* name){
+	TraceRing* _ring = traceRing != NULL ? traceRing : new TraceRing();
+
+	// The name is read by traceFlush(), under the same lock
+	std::lock_guard<std::mutex> _lock(ringsLock);
+	strncpy(_ring->threadName, name, sizeof(_ring->threadName) - 1);
+	_ring->threadName[sizeof(_ring->threadName) - 1] = 0;
+	if (traceRing == NULL){
+		_ring->threadID = (uint32)rings.size() + 1;
+		rings.push_back(_ring);
+		traceRing = _ring;
+	}
+}
+
+int traceFlush(const char* path){
+	std::vector<TraceRing*> _rings;
+	std::vector<std::string> _names;
+	{
+		std::lock_guard<std::mutex> _lock(ringsLock);
+		_rings = rings;
+		for (size_t _r = 0; _r < rings.size(); _r++)
+			_names.push_back(rings[_r]->threadName);
+	}
+
+	FILE* _file = fopen(path, "w");
+	if (_file == NULL)
+		return -1;
+
+	fprintf(_file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	int _count = 0;
+	std::vector<Copied> _events;
+	for (size_t _r = 0; _r < _rings.size(); _r++){
+		const TraceRing& _ring = *_rings[_r];
+		fprintf(_file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+			_r > 0 ? ",\n" : "", _ring.threadID, _names[_r].c_str());
+
+		// The ring may have wrapped between a begin and its end, ends with no begin are left out
+		copyRing(_ring, _events);
+		int _depth = 0;
+		for (size_t _e = 0; _e < _events.size(); _e++){
+			bool _end = (_events[_e].time & TraceRing::endBit) != 0;
+			if (_end && _depth == 0)
+				continue;
+			_depth += _end ? -1 : 1;
+
+			uint64 _ns = _events[_e].time & ~TraceRing::endBit;
+			fprintf(_file, ",\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%llu.%03u,\"pid\":1,\"tid\":%u}", _events[_e].name,
+				_end ? 'E' : 'B', (unsigned long long)(_ns / 1000), (unsigned)(_ns % 1000), _ring.threadID);
+			_count++;
+		}
+	}
+	fprintf(_file, "\n]}\n");
+
+	bool _written = !ferror(_file);
+	if (fclose(_file) != 0)
+		_written = false;
+	return _written ? _count : -1;
+}
+
+#endif
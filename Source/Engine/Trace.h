@@ -0,0 +1,90 @@
+/*Tetris
+Description: Timeline tracing of frame + simulation phases, written as a Chrome trace.
+
+			Only built when TETRIS_TRACE is defined (debug builds), otherwise the TRACE_ macros
+			expand to nothing and none of this is compiled. A thread opts in with TRACE_THREAD,
+			which gives it its own ring of events, and TRACE_SCOPE then records a begin + end
+			event there: a thread local load and two timestamps, no locks or shared writes. A
+			thread that never opted in (bot search workers etc.) pays a single branch. Rings wrap,
+			so they always hold the last few seconds of every thread.
+
+			traceFlush() copies every ring and writes the events as Chrome/ Perfetto trace JSON
+			(chrome://tracing or ui.perfetto.dev), one track per thread. It can run on any thread
+			while the others keep recording, events overwritten during the copy are left out.
+*/
+
+#pragma once
+
+#ifdef TETRIS_TRACE
+
+#include <atomic>
+
+#include "../Common.h"
+
+class TraceRing{
+public:
+	static const uint32 size = 1 << 16;		//!< Events kept per thread, a power of 2
+	static const uint64 endBit = 1ULL << 63;
+
+	struct Event{
+		std::atomic<const char*> name;
+		std::atomic<uint64> time;		//!< ns since the trace started, endBit set for an end
+	};
+
+	//!< Owning thread only
+	void record(const char* name, bool end);
+
+	std::atomic<uint64> writing{ 0 };	//!< Bumped before an event is written
+	std::atomic<uint64> head{ 0 };		//!< Bumped once it has been
+	Event events[size];
+	char threadName[32];
+	uint32 threadID = 0;
+};
+
+extern thread_local TraceRing* traceRing;
+
+//!< Gives the calling thread a ring named name, events are only recorded on threads that have one
+void traceThread(const char* name);
+
+//!< Writes every thread's events to path, returns how many or -1 if it could not be written
+int traceFlush(const char* path);
+
+inline void traceEvent(const char* name, bool end){
+	TraceRing* _ring = traceRing;
+	if (_ring != NULL)
+		_ring->record(name, end);
+}
+
+//!< Records the enclosing scope
+class TraceScope{
+public:
+	TraceScope(const char* _name) : name(_name) { traceEvent(name, false); }
+	~TraceScope() { traceEvent(name, true); }
+private:
+	const char* name;
+};
+
+//!< Stops recording on this thread for the enclosing scope, for work too fine grained to show
+class TraceMute{
+public:
+	TraceMute() : ring(traceRing) { traceRing = NULL; }
+	~TraceMute() { traceRing = ring; }
+private:
+	TraceRing* ring;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(_traceScope, __LINE__)(name)
+#define TRACE_MUTE() TraceMute TRACE_CONCAT(_traceMute, __LINE__)
+#define TRACE_THREAD(name) traceThread(name)
+#define TRACE_FLUSH(path) traceFlush(path)
+
+#else
+
+#define TRACE_SCOPE(name)
+#define TRACE_MUTE()
+#define TRACE_THREAD(name)
+#define TRACE_FLUSH(path) (-1)
+
+#endif
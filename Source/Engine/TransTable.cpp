@@ -0,0 +1,203 @@
+#include "TransTable.h"
+
+#include "Encoders.h"
+
+#include <cstdint>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace{
+
+	const size_t hugePageSize = 2 * 1024 * 1024;
+
+	// splitmix64 finaliser
+	uint64 mix(uint64 value){
+		value ^= value >> 30;
+		value *= 0xBF58476D1CE4E5B9ull;
+		value ^= value >> 27;
+		value *= 0x94D049BB133111EBull;
+		return value ^ (value >> 31);
+	}
+
+#ifdef _WIN32
+	// Large pages need SeLockMemoryPrivilege turned on for the process, the account must hold it
+	bool enableLockMemory(){
+		HANDLE _token;
+		if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &_token))
+			return false;
+
+		TOKEN_PRIVILEGES _privileges;
+		_privileges.PrivilegeCount = 1;
+		_privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+		bool _ok = LookupPrivilegeValue(NULL, SE_LOCK_MEMORY_NAME, &_privileges.Privileges[0].Luid) &&
+			AdjustTokenPrivileges(_token, FALSE, &_privileges, 0, NULL, NULL) &&
+			GetLastError() == ERROR_SUCCESS;
+		CloseHandle(_token);
+		return _ok;
+	}
+#endif
+
+}
+
+uint64 boardHash(const Game& game){
+	uint16 _rows[Game::height];
+	encodeRows(game, _rows);
+
+	// 6 rows to a word, then mixed together
+	uint64 _hash = 0;
+	uint64 _word = 0;
+	int _packed = 0;
+	for (int _y = 0; _y < Game::height; _y++){
+		_word = (_word << boardColumns) | _rows[_y];
+		if (++_packed == 6 || _y == Game::height - 1){
+			_hash = mix(_hash ^ _word);
+			_word = 0;
+			_packed = 0;
+		}
+	}
+	return _hash;
+}
+
+TransTable::TransTable(size_t sizeMB){
+	size_t _size = sizeMB * 1024 * 1024;
+	if (_size < sizeof(Bucket))
+		return;
+
+	bucketCount = 1;
+	while (bucketCount * 2 * sizeof(Bucket) <= _size)
+		bucketCount *= 2;
+	size_t _bytes = bucketCount * sizeof(Bucket);
+
+#ifdef _WIN32
+	SIZE_T _largePage = GetLargePageMinimum();
+	if (_largePage > 0 && enableLockMemory()){
+		memorySize = (_bytes + _largePage - 1) / _largePage * _largePage;
+		memory = VirtualAlloc(NULL, memorySize, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+		hugePages = memory != NULL;
+	}
+	if (memory == NULL){
+		memorySize = _bytes;
+		memory = VirtualAlloc(NULL, memorySize, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+	}
+	buckets = (Bucket*)memory;
+#else
+	// Transparent huge pages only back 2MB aligned ranges, map extra to align inside
+	memorySize = _bytes >= hugePageSize ? _bytes + hugePageSize : _bytes;
+	memory = mmap(NULL, memorySize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (memory == MAP_FAILED)
+		memory = NULL;
+
+	if (memory != NULL){
+		uintptr_t _address = (uintptr_t)memory;
+		if (_bytes >= hugePageSize)
+			_address = (_address + hugePageSize - 1) & ~(uintptr_t)(hugePageSize - 1);
+		buckets = (Bucket*)_address;
+#ifdef MADV_HUGEPAGE
+		hugePages = _bytes >= hugePageSize && madvise(buckets, _bytes, MADV_HUGEPAGE) == 0;
+#endif
+	}
+#endif
+
+	// Fresh pages are already zero, which reads as unused (a stored entry never packs to 0)
+	if (buckets == NULL){
+		bucketCount = 0;
+		memory = NULL;
+	}
+}
+
+TransTable::~TransTable(){
+	if (memory == NULL)
+		return;
+#ifdef _WIN32
+	VirtualFree(memory, 0, MEM_RELEASE);
+#else
+	munmap(memory, memorySize);
+#endif
+}
+
+void TransTable::clear(){
+	for (size_t _b = 0; _b < bucketCount; _b++){
+		for (int _e = 0; _e < bucketSize; _e++){
+			buckets[_b].entries[_e].check.store(0, std::memory_order_relaxed);
+			buckets[_b].entries[_e].data.store(0, std::memory_order_relaxed);
+		}
+	}
+}
+
+uint64 TransTable::pack(const TransData& data){
+	uint32 _score;
+	memcpy(&_score, &data.score, sizeof(_score));
+
+	// Score 32 bits, generation 15, depth 4, x 5 (from -2), y 5, rotation 2, 1 bit to mark a used entry
+	return (uint64)_score |
+		((uint64)(data.generation & maxGeneration) << 32) |
+		((uint64)(data.depth & 15) << 47) |
+		((uint64)((data.best.x + 2) & 31) << 51) |
+		((uint64)(data.best.y & 31) << 56) |
+		((uint64)(data.best.rotation & 3) << 61) |
+		(1ull << 63);
+}
+
+TransData TransTable::unpack(uint64 data){
+	TransData _data;
+	uint32 _score = (uint32)data;
+	memcpy(&_data.score, &_score, sizeof(_score));
+	_data.generation = (uint16)((data >> 32) & maxGeneration);
+	_data.depth = (uint8)((data >> 47) & 15);
+	_data.best.x = (sint8)(((data >> 51) & 31) - 2);
+	_data.best.y = (sint8)((data >> 56) & 31);
+	_data.best.rotation = (uint8)((data >> 61) & 3);
+	_data.best.node = 0;
+	return _data;
+}
+
+bool TransTable::probe(uint64 key, TransData& data) const{
+	if (bucketCount == 0)
+		return false;
+
+	const Bucket& _bucket = buckets[key & (bucketCount - 1)];
+	for (int _e = 0; _e < bucketSize; _e++){
+		uint64 _data = _bucket.entries[_e].data.load(std::memory_order_relaxed);
+		uint64 _check = _bucket.entries[_e].check.load(std::memory_order_relaxed);
+		if (_data != 0 && (_check ^ _data) == key){
+			data = unpack(_data);
+			return true;
+		}
+	}
+	return false;
+}
+
+void TransTable::store(uint64 key, const TransData& data){
+	if (bucketCount == 0)
+		return;
+
+	Bucket& _bucket = buckets[key & (bucketCount - 1)];
+
+	// Same key, else the entry least worth keeping: unused, older search, shallower
+	int _replace = 0;
+	int _worst = 1 << 30;
+	for (int _e = 0; _e < bucketSize; _e++){
+		uint64 _data = _bucket.entries[_e].data.load(std::memory_order_relaxed);
+		uint64 _check = _bucket.entries[_e].check.load(std::memory_order_relaxed);
+		if (_data == 0 || (_check ^ _data) == key){
+			_replace = _e;
+			break;
+		}
+
+		TransData _old = unpack(_data);
+		int _value = (_old.generation == data.generation ? 16 : 0) + _old.depth;
+		if (_value < _worst){
+			_worst = _value;
+			_replace = _e;
+		}
+	}
+
+	uint64 _data = pack(data);
+	_bucket.entries[_replace].data.store(_data, std::memory_order_relaxed);
+	_bucket.entries[_replace].check.store(key ^ _data, std::memory_order_relaxed);
+}
@@ -0,0 +1,72 @@
+/*Tetris
+Description: Transposition table, remembers what the search found for boards it has already seen.
+
+			Fixed size and shared between threads without locks. Entries are two 64 bit words,
+			the key xor the data and the data. Readers recompute the key from both words, an entry
+			torn by two threads writing it at once no longer matches its key and reads as a miss,
+			so no entry ever needs a lock. Four entries share a 64 byte bucket, a store replaces
+			the same key, then an entry from an older search, then the shallowest.
+
+			The memory is asked for on huge pages (transparent huge pages on Linux, large pages on
+			Windows if the account may lock memory) so big tables do not thrash the TLB, with
+			ordinary pages as the fallback.
+*/
+
+#pragma once
+
+#include <atomic>
+
+#include "Game.h"
+#include "MoveGen.h"
+
+//!< 64 bit hash of which cells of game's grid are filled, colours and the falling block are ignored
+uint64 boardHash(const Game& game);
+
+//!< What the table keeps for a board
+struct TransData{
+	float score;			//!< Evaluation
+	uint8 depth;			//!< Depth it was searched to, 0 - 15
+	uint16 generation;		//!< Search that stored it, up to TransTable::maxGeneration
+	Placement best;			//!< Best placement known from the board, node is not kept
+};
+
+class TransTable{
+public:
+	static const int bucketSize = 4;
+	static const uint16 maxGeneration = 0x7FFF;		//!< Largest generation kept, clear the table before counting past it
+
+	//!< sizeMB is rounded down to a power of two number of buckets, 0 for no table
+	explicit TransTable(size_t sizeMB = 16);
+	~TransTable();
+
+	bool probe(uint64 key, TransData& data) const;
+	void store(uint64 key, const TransData& data);
+
+	//!< Empties the table, not safe while other threads use it
+	void clear();
+
+	size_t getBucketCount() const { return bucketCount; }
+	bool onHugePages() const { return hugePages; }
+
+private:
+	TransTable(const TransTable&);
+	TransTable& operator=(const TransTable&);
+
+	struct Entry{
+		std::atomic<uint64> check;	//!< key ^ data
+		std::atomic<uint64> data;
+	};
+
+	struct Bucket{
+		Entry entries[bucketSize];
+	};
+
+	static uint64 pack(const TransData& data);
+	static TransData unpack(uint64 data);
+
+	Bucket* buckets = NULL;
+	size_t bucketCount = 0;
+	void* memory = NULL;		//!< As allocated, buckets is aligned inside it
+	size_t memorySize = 0;
+	bool hugePages = false;
+};
@@ -0,0 +1,129 @@
+#include "Versus.h"
+
+namespace{
+
+	void hashBytes(uint64& hash, const void* data, size_t size){
+		const uint8* _bytes = (const uint8*)data;
+		for (size_t _i = 0; _i < size; _i++){
+			hash ^= _bytes[_i];
+			hash *= 0x100000001B3ULL;
+		}
+	}
+
+	void hashValue(uint64& hash, uint32 value){
+		hashBytes(hash, &value, sizeof(value));
+	}
+
+}
+
+int versusGarbage(int lines){
+	static const int _garbage[5] = { 0, 0, 1, 2, 4 };
+	return lines < 0 ? 0 : _garbage[lines < 4 ? lines : 4];
+}
+
+void VersusMatch::reset(uint64 seed){
+	for (int _p = 0; _p < players; _p++){
+		games[_p].reset(seed);
+		games[_p].setEndless(false);
+		games[_p].newBlock();
+		pendingGarbage[_p] = 0;
+		garbageSent[_p] = 0;
+	}
+	frame = 0;
+	randomState = (seed * 0x9E3779B97F4A7C15ULL) | 1;
+	winner = noWinner;
+}
+
+int VersusMatch::nextHole(){
+	randomState ^= randomState >> 12;
+	randomState ^= randomState << 25;
+	randomState ^= randomState >> 27;
+	return (int)(((randomState * 0x2545F4914F6CDD1DULL) >> 32) % (Game::width - 2));
+}
+
+void VersusMatch::applyInput(Game& game, uint8 input){
+	if (input & VERSUS_ROTATE)
+		game.rotateBlock();
+	if (input & VERSUS_LEFT)
+		game.moveLeft();
+	if (input & VERSUS_RIGHT)
+		game.moveRight();
+	if (input & VERSUS_DROP)
+		game.dropDown();
+	game.setSoftDrop((input & VERSUS_SOFT_DROP) != 0);
+}
+
+void VersusMatch::step(const uint8* inputs){
+	if (isOver()){
+		frame++;
+		return;
+	}
+
+	int _cleared[players];
+	bool _locked[players];
+	for (int _p = 0; _p < players; _p++){
+		uint32 _lines = games[_p].getLinesCleared();
+		uint32 _blocks = games[_p].getBlocksPlaced();
+		applyInput(games[_p], inputs[_p]);
+		games[_p].update(versusFrameMS);
+		_cleared[_p] = (int)(games[_p].getLinesCleared() - _lines);
+		_locked[_p] = games[_p].getBlocksPlaced() != _blocks;
+	}
+
+	// Both players' garbage is worked out before any moves, so neither goes first
+	int _outgoing[players];
+	for (int _p = 0; _p < players; _p++){
+		int _sent = versusGarbage(_cleared[_p]);
+		int _cancelled = _sent < pendingGarbage[_p] ? _sent : pendingGarbage[_p];
+		pendingGarbage[_p] -= _cancelled;
+		_outgoing[_p] = _sent - _cancelled;
+	}
+
+	// Garbage already waiting comes up on a lock that cleared nothing
+	for (int _p = 0; _p < players; _p++){
+		if (_locked[_p] && _cleared[_p] == 0 && pendingGarbage[_p] > 0 && !games[_p].isGameOver()){
+			games[_p].addGarbage(pendingGarbage[_p], nextHole());
+			pendingGarbage[_p] = 0;
+		}
+	}
+
+	for (int _p = 0; _p < players; _p++){
+		int& _pending = pendingGarbage[players - 1 - _p];
+		_pending = _pending + _outgoing[_p] < maxPendingGarbage ? _pending + _outgoing[_p] : maxPendingGarbage;
+		garbageSent[_p] += _outgoing[_p];
+	}
+
+	frame++;
+
+	bool _lost0 = games[0].isGameOver();
+	bool _lost1 = games[1].isGameOver();
+	if (_lost0 || _lost1)
+		winner = _lost0 && _lost1 ? -1 : (_lost0 ? 1 : 0);
+}
+
+uint64 VersusMatch::checksum() const{
+	uint64 _hash = 0xCBF29CE484222325ULL;
+	hashValue(_hash, frame);
+	hashValue(_hash, (uint32)winner);
+	hashBytes(_hash, &randomState, sizeof(randomState));
+	for (int _p = 0; _p < players; _p++){
+		const Game& _game = games[_p];
+		hashBytes(_hash, _game.getGrid(), Game::cellCount);
+		hashBytes(_hash, _game.getCurrentBlock(), 16);
+		hashValue(_hash, (uint32)_game.getBlockPosition().x);
+		hashValue(_hash, (uint32)_game.getBlockPosition().y);
+		hashValue(_hash, _game.getCurrentBlockID());
+		for (int _i = 0; _i < Game::previewSize; _i++)
+			hashValue(_hash, _game.getPreview(_i));
+		uint64 _random = _game.getRandomState();
+		hashBytes(_hash, &_random, sizeof(_random));
+		float _dropElapsed = _game.getDropElapsed();
+		hashBytes(_hash, &_dropElapsed, sizeof(_dropElapsed));
+		hashValue(_hash, _game.getDropMS());
+		hashValue(_hash, _game.isGameOver() ? 1 : 0);
+		hashValue(_hash, _game.getLinesCleared());
+		hashValue(_hash, _game.getBlocksPlaced());
+		hashValue(_hash, (uint32)pendingGarbage[_p]);
+	}
+	return _hash;
+}
@@ -0,0 +1,74 @@
+/*Tetris
+Description: Two player versus rules, two games side by side sending each other garbage.
+
+			A VersusMatch only moves on by whole frames given both players' input for that frame,
+			nothing else (no clock, no random numbers of its own outside the class) goes into it.
+			Given the same seed and inputs it always ends up in the same state, which is what lets
+			RollbackSession rewind it to a copy and play frames again. A copy is the snapshot: two
+			games + a few counters, well under a kilobyte.
+
+			Clearing 2, 3 or 4 lines at once sends 1, 2 or 4 rows of garbage. It first cancels
+			garbage waiting to come up on the sender's own board, the rest waits on the other
+			board and comes up the next time that player locks a block without clearing a line.
+			Both games get the same block sequence. The first to top out loses.
+*/
+
+#pragma once
+
+#include "Game.h"
+
+//!< One frame of a player's input, bits
+enum VERSUS_INPUT{
+	VERSUS_LEFT = 0x1,
+	VERSUS_RIGHT = 0x2,
+	VERSUS_ROTATE = 0x4,
+	VERSUS_DROP = 0x8,			//!< One dropDown(), locks the block if it can not move down
+	VERSUS_SOFT_DROP = 0x10,	//!< Held, falls at the faster rate
+	VERSUS_INPUT_MASK = 0x1F
+};
+
+const int versusFrameRate = 60;
+const float versusFrameMS = 1000.0f / versusFrameRate;
+
+//!< Garbage rows sent for clearing lines (0 - 4) with one block
+int versusGarbage(int lines);
+
+class VersusMatch{
+public:
+	static const int players = 2;
+	static const int maxPendingGarbage = Game::height;
+
+	explicit VersusMatch(uint64 seed = 1) { reset(seed); }
+
+	void reset(uint64 seed);
+
+	//!< Plays one frame, inputs holds both players' VERSUS_INPUT bits. Once a player has lost only
+	//!< the frame count moves on.
+	void step(const uint8* inputs);
+
+	const Game& getGame(int player) const { return games[player]; }
+	uint32 getFrame() const { return frame; }
+	int getPendingGarbage(int player) const { return pendingGarbage[player]; }
+	uint32 getGarbageSent(int player) const { return garbageSent[player]; }
+
+	bool isOver() const { return winner != noWinner; }
+	int getWinner() const { return winner; }		//!< Player index, -1 for a draw, only once isOver()
+
+	//!< Hash of everything that decides what happens next (frame, winner, garbage holes + pending garbage,
+	//!< each game's grid, falling block, preview, generator, drop timer, game over + counts), equal on
+	//!< both machines unless they desynced. garbageSent is only a statistic and is left out.
+	uint64 checksum() const;
+
+private:
+	static const int noWinner = -2;
+
+	void applyInput(Game& game, uint8 input);
+	int nextHole();
+
+	Game games[players];
+	uint32 frame = 0;
+	uint64 randomState = 1;		//!< Garbage hole columns
+	int pendingGarbage[players] = {};
+	uint32 garbageSent[players] = {};
+	int winner = noWinner;
+};
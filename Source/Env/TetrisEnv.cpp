@@ -0,0 +1,229 @@
+#include "TetrisEnv.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "../Engine/Encoders.h"
+#include "../Engine/Game.h"
+#include "../Engine/Scheduler.h"
+
+static_assert(TETRIS_OBSERVATION_QUEUE + Game::previewSize == TETRIS_OBSERVATION_SIZE, "Observation layout");
+static_assert(planeSize == TETRIS_OBSERVATION_BLOCK, "Observation layout");
+static_assert(ENCODED_FEATURE_COUNT == TETRIS_ENCODED_FEATURE_COUNT, "Feature vector layout");
+
+namespace{
+
+	//!< One game of the batch
+	struct EnvGame{
+		Game game;
+		uint64 seed;			//!< Of the episode being played
+		uint32 steps;
+		int gravity;			//!< Steps until gravity drops the block
+	};
+
+	enum RANGE_TASK{
+		RANGE_RESET,
+		RANGE_STEP,
+		RANGE_ENCODE
+	};
+
+	//!< Task data, games begin to end of a reset, step or encode
+	struct EnvRange{
+		TetrisEnv* env;
+		RANGE_TASK task;
+		int begin;
+		int end;
+		const uint64_t* seeds;		//!< Reset only
+		const uint8_t* actions;		//!< Step only
+		uint8_t* observations;
+		float* rewards;
+		uint8_t* dones;
+		int encoding;				//!< Encode only
+		void* encoded;
+	};
+
+	// splitmix64, the seed of a game's next episode
+	uint64 nextSeed(uint64 seed){
+		uint64 _z = seed + 0x9E3779B97F4A7C15ull;
+		_z = (_z ^ (_z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		_z = (_z ^ (_z >> 27)) * 0x94D049BB133111EBull;
+		return _z ^ (_z >> 31);
+	}
+
+	void writeObservation(const Game& game, uint8_t* observation){
+		encodeBoard(game, &observation[TETRIS_OBSERVATION_BOARD]);
+
+		Vec2 _position = game.getBlockPosition();
+		observation[TETRIS_OBSERVATION_BLOCK] = game.getCurrentBlockID();
+		observation[TETRIS_OBSERVATION_BLOCK_X] = (uint8_t)(_position.x + 2);
+		observation[TETRIS_OBSERVATION_BLOCK_Y] = (uint8_t)_position.y;
+
+		const uint8* _block = game.getCurrentBlock();
+		for (int _i = 0; _i < 16; _i++)
+			observation[TETRIS_OBSERVATION_LAYOUT + _i] = _block[_i] != 0;
+
+		for (int _p = 0; _p < Game::previewSize; _p++)
+			observation[TETRIS_OBSERVATION_QUEUE + _p] = game.getPreview(_p);
+	}
+
+}
+
+struct TetrisEnv{
+	std::vector<EnvGame> games;
+	int gravitySteps;
+	int maxSteps;
+	int chunkSize;			//!< Games per task
+	Scheduler scheduler;
+
+	TetrisEnv(int count, int threads, int _gravitySteps, int _maxSteps)
+		: games(count), gravitySteps(_gravitySteps), maxSteps(_maxSteps), scheduler(threads){
+		// A few tasks per worker so stealing can even out games that reset
+		chunkSize = std::max(64, count / (scheduler.workerCount() * 4));
+	}
+
+	void start(EnvGame& game, uint64 seed){
+		game.game.reset(seed);
+		game.game.setEndless(false);
+		game.game.newBlock();
+		game.seed = seed;
+		game.steps = 0;
+		game.gravity = gravitySteps;
+	}
+
+	// Returns lines cleared, done is set to a TETRIS_DONE
+	float step(EnvGame& game, uint8_t action, uint8_t& done){
+		Game& _game = game.game;
+		uint32 _lines = _game.getLinesCleared();
+
+		switch (action){
+		case TETRIS_ACTION_LEFT: _game.moveLeft(); break;
+		case TETRIS_ACTION_RIGHT: _game.moveRight(); break;
+		case TETRIS_ACTION_ROTATE: _game.rotateBlock(); break;
+		case TETRIS_ACTION_SOFT_DROP: _game.dropDown(); break;
+		case TETRIS_ACTION_HARD_DROP:
+			while (!_game.isGameOver() && !_game.dropDown()){}
+			break;
+		default: break;
+		}
+
+		if (--game.gravity <= 0){
+			game.gravity = gravitySteps;
+			if (!_game.isGameOver())
+				_game.dropDown();
+		}
+
+		game.steps++;
+		done = TETRIS_RUNNING;
+		if (_game.isGameOver())
+			done = TETRIS_TOPPED_OUT;
+		else if (maxSteps > 0 && game.steps >= (uint32)maxSteps)
+			done = TETRIS_TRUNCATED;
+
+		return (float)(_game.getLinesCleared() - _lines);
+	}
+
+	static void rangeTask(Scheduler&, int, void* data){
+		const EnvRange& _range = *(const EnvRange*)data;
+		TetrisEnv& _env = *_range.env;
+
+		if (_range.task == RANGE_ENCODE){
+			encode(_env, _range);
+			return;
+		}
+
+		for (int _g = _range.begin; _g < _range.end; _g++){
+			EnvGame& _game = _env.games[_g];
+			if (_range.task == RANGE_RESET){
+				_env.start(_game, _range.seeds[_g]);
+			}
+			else{
+				uint8_t _done;
+				float _reward = _env.step(_game, _range.actions[_g], _done);
+				if (_done != TETRIS_RUNNING)
+					_env.start(_game, nextSeed(_game.seed));
+
+				if (_range.rewards != NULL)
+					_range.rewards[_g] = _reward;
+				if (_range.dones != NULL)
+					_range.dones[_g] = _done;
+			}
+
+			if (_range.observations != NULL)
+				writeObservation(_game.game, &_range.observations[(size_t)_g * TETRIS_OBSERVATION_SIZE]);
+		}
+	}
+
+	static void encode(TetrisEnv& env, const EnvRange& range){
+		size_t _size = (size_t)tetrisEnvEncodingSize(range.encoding);
+		uint8* _out = (uint8*)range.encoded + (_size * range.begin);
+
+		for (int _g = range.begin; _g < range.end; _g++, _out += _size){
+			const Game& _game = env.games[_g].game;
+			switch (range.encoding){
+			case TETRIS_ENCODING_ROWS: encodeRows(_game, (uint16*)_out); break;
+			case TETRIS_ENCODING_PLANES: encodePlanes(_game, (float*)_out); break;
+			case TETRIS_ENCODING_FEATURES: encodeFeatures(_game, (float*)_out); break;
+			}
+		}
+	}
+
+	void run(EnvRange range){
+		Scheduler::Group _group;
+		int _count = (int)games.size();
+		for (int _begin = 0; _begin < _count; _begin += chunkSize){
+			range.begin = _begin;
+			range.end = std::min(_begin + chunkSize, _count);
+			scheduler.spawn(_group, &TetrisEnv::rangeTask, range, 0);
+		}
+		scheduler.wait(_group, 0);
+	}
+};
+
+TetrisEnv* tetrisEnvCreate(int count, int threads, int gravitySteps, int maxSteps){
+	if (count <= 0 || gravitySteps <= 0 || maxSteps < 0)
+		return NULL;
+
+	TetrisEnv* _env = new TetrisEnv(count, threads, gravitySteps, maxSteps);
+	for (int _g = 0; _g < count; _g++)
+		_env->start(_env->games[_g], (uint64)_g + 1);
+	return _env;
+}
+
+void tetrisEnvDestroy(TetrisEnv* env){
+	delete env;
+}
+
+int tetrisEnvCount(const TetrisEnv* env){
+	return (int)env->games.size();
+}
+
+int tetrisEnvObservationSize(void){
+	return TETRIS_OBSERVATION_SIZE;
+}
+
+int tetrisEnvEncodingSize(int encoding){
+	switch (encoding){
+	case TETRIS_ENCODING_ROWS: return Game::height * (int)sizeof(uint16);
+	case TETRIS_ENCODING_PLANES: return planeCount * planeSize * (int)sizeof(float);
+	case TETRIS_ENCODING_FEATURES: return ENCODED_FEATURE_COUNT * (int)sizeof(float);
+	}
+	return 0;
+}
+
+void tetrisEnvReset(TetrisEnv* env, const uint64_t* seeds, uint8_t* observations){
+	EnvRange _range = { env, RANGE_RESET, 0, 0, seeds, NULL, observations, NULL, NULL, 0, NULL };
+	env->run(_range);
+}
+
+void tetrisEnvStep(TetrisEnv* env, const uint8_t* actions, uint8_t* observations, float* rewards, uint8_t* dones){
+	EnvRange _range = { env, RANGE_STEP, 0, 0, NULL, actions, observations, rewards, dones, 0, NULL };
+	env->run(_range);
+}
+
+void tetrisEnvEncode(TetrisEnv* env, int encoding, void* out){
+	if (tetrisEnvEncodingSize(encoding) == 0)
+		return;
+	EnvRange _range = { env, RANGE_ENCODE, 0, 0, NULL, NULL, NULL, NULL, NULL, encoding, out };
+	env->run(_range);
+}
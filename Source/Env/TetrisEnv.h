@@ -0,0 +1,100 @@
+/*Tetris
+Description: Batched environment for reinforcement learning, a C interface to a shared library.
+
+			One handle runs count games side by side. Every call takes arrays laid out one entry
+			per game, owned by the caller, and writes straight into them: a step is one input
+			for every game, written back as each game's observation, reward and done flag. A
+			game that ends is reset straight away (the observation is then of the new game) with
+			the next seed of its own sequence, so a batch never has to stop. Nothing is allocated
+			after tetrisEnvCreate(). The batch is split between threads.
+
+			Observations are tetrisEnvObservationSize bytes each, see TETRIS_OBSERVATION. Game i's
+			episodes after the first are seeded with splitmix64 of the seed before.
+
+			TetrisEnv.dll on Windows, on Linux:
+				g++ -O2 -std=c++14 -shared -fPIC -fvisibility=hidden -pthread -ISource Source/Env/TetrisEnv.cpp \
+					Source/Engine/Game.cpp Source/Engine/Scheduler.cpp Source/Engine/Encoders.cpp -o libtetrisenv.so
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef _WIN32
+	#ifdef TETRIS_ENV_EXPORTS
+		#define TETRIS_ENV_API __declspec(dllexport)
+	#else
+		#define TETRIS_ENV_API __declspec(dllimport)
+	#endif
+#else
+	#define TETRIS_ENV_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//!< Inputs, one per game per step. Gravity drops the block one row every gravitySteps steps as well.
+enum TETRIS_ACTION{
+	TETRIS_ACTION_NONE,
+	TETRIS_ACTION_LEFT,
+	TETRIS_ACTION_RIGHT,
+	TETRIS_ACTION_ROTATE,
+	TETRIS_ACTION_SOFT_DROP,		//!< Down one row, locks if it can not move
+	TETRIS_ACTION_HARD_DROP,		//!< Down until it locks
+	TETRIS_ACTION_COUNT
+};
+
+//!< Byte offsets into an observation
+enum TETRIS_OBSERVATION{
+	TETRIS_OBSERVATION_BOARD = 0,			//!< 10 x 22 cells, 1 filled, rows top to bottom
+	TETRIS_OBSERVATION_BLOCK = 220,			//!< Falling block id 0 - 6
+	TETRIS_OBSERVATION_BLOCK_X = 221,		//!< Pivot column + 2
+	TETRIS_OBSERVATION_BLOCK_Y = 222,		//!< Pivot row
+	TETRIS_OBSERVATION_LAYOUT = 223,		//!< 4 x 4 cells of the falling block as rotated, 1 filled
+	TETRIS_OBSERVATION_QUEUE = 239,			//!< Next 5 block ids, next first
+	TETRIS_OBSERVATION_SIZE = 244
+};
+
+//!< Values of the done flags
+enum TETRIS_DONE{
+	TETRIS_RUNNING,
+	TETRIS_TOPPED_OUT,
+	TETRIS_TRUNCATED			//!< Reached maxSteps
+};
+
+//!< Other forms of the board tetrisEnvEncode() writes, rows top to bottom
+enum TETRIS_ENCODING{
+	TETRIS_ENCODING_ROWS,			//!< 22 uint16 a game, bit x set if column x is filled
+	TETRIS_ENCODING_PLANES,			//!< 2 x 220 floats a game, 1 filled: the board then the falling block
+	TETRIS_ENCODING_FEATURES		//!< TETRIS_ENCODED_FEATURE_COUNT floats a game: 10 column heights, holes,
+									//!< row transitions, column transitions, max height, bumpiness, wells
+};
+
+#define TETRIS_ENCODED_FEATURE_COUNT 16
+
+typedef struct TetrisEnv TetrisEnv;
+
+//!< count games, threads 0 for one per core, maxSteps 0 for no limit. Returns NULL on bad arguments.
+TETRIS_ENV_API TetrisEnv* tetrisEnvCreate(int count, int threads, int gravitySteps, int maxSteps);
+TETRIS_ENV_API void tetrisEnvDestroy(TetrisEnv* env);
+
+TETRIS_ENV_API int tetrisEnvCount(const TetrisEnv* env);
+TETRIS_ENV_API int tetrisEnvObservationSize(void);
+
+//!< Starts every game over, game i from seeds[i]. observations: count * TETRIS_OBSERVATION_SIZE bytes.
+TETRIS_ENV_API void tetrisEnvReset(TetrisEnv* env, const uint64_t* seeds, uint8_t* observations);
+
+//!< Applies actions[i] (TETRIS_ACTION) to game i, rewards are lines cleared, dones are TETRIS_DONE.
+//!< Any of observations, rewards + dones may be NULL to skip writing them.
+TETRIS_ENV_API void tetrisEnvStep(TetrisEnv* env, const uint8_t* actions, uint8_t* observations, float* rewards, uint8_t* dones);
+
+//!< Bytes a game takes in encoding (TETRIS_ENCODING), 0 if it is not one
+TETRIS_ENV_API int tetrisEnvEncodingSize(int encoding);
+
+//!< Writes every game's board as encoding into out, count * tetrisEnvEncodingSize() bytes
+TETRIS_ENV_API void tetrisEnvEncode(TetrisEnv* env, int encoding, void* out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,158 @@
+/*Tetris
+Description: Lock free hand off of whole frames between a single producer and a single consumer thread.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <thread>
+
+#include "Common.h"
+
+//!< Two slot exchange, the producer fills one slot while the consumer holds the other.
+//!< The consumer keeps hold of the last slot it acquired (so it can be drawn again) until a newer
+//!< one is ready, a frame the consumer never got to is overwritten rather than waited on.
+template <typename T>
+class DoubleBufferExchange{
+public:
+	DoubleBufferExchange(){
+		for (int _i = 0; _i < 2; _i++){
+			state[_i].store(FREE);
+			sequence[_i].store(0);
+		}
+	}
+
+	//!< Producer: returns a slot to fill, call publish() once done
+	T* beginWrite(){
+		for (;;){
+			// Prefer a free slot, otherwise reclaim a frame the consumer has not picked up yet
+			for (int _from = FREE; _from <= READY; _from += READY - FREE){
+				for (int _i = 0; _i < 2; _i++){
+					int _expected = _from;
+					if (state[_i].compare_exchange_strong(_expected, WRITING)){
+						writing = _i;
+						return &slots[_i];
+					}
+				}
+			}
+			// Both slots are briefly READING while the consumer swaps from one to the other
+			std::this_thread::yield();
+		}
+	}
+
+	//!< Producer: makes the slot returned by beginWrite() visible to the consumer
+	void publish(){
+		sequence[writing].store(++published, std::memory_order_relaxed);
+		state[writing].store(READY, std::memory_order_release);
+	}
+
+	//!< Consumer: returns the newest published slot, or NULL if nothing newer than the held slot
+	const T* acquire(){
+		int _newest = -1;
+		for (int _i = 0; _i < 2; _i++){
+			if (_i != reading && state[_i].load(std::memory_order_acquire) == READY){
+				// A stale slot can stay READY when the producer filled the free slot instead
+				uint64 _sequence = sequence[_i].load(std::memory_order_relaxed);
+				if (_sequence > readSequence && (_newest < 0 || _sequence > sequence[_newest].load(std::memory_order_relaxed)))
+					_newest = _i;
+			}
+		}
+		if (_newest < 0)
+			return NULL;
+
+		int _expected = READY;
+		if (!state[_newest].compare_exchange_strong(_expected, READING, std::memory_order_acquire))
+			return NULL; // Producer reclaimed it, it will be published again shortly
+
+		if (reading >= 0)
+			state[reading].store(FREE, std::memory_order_release);
+		reading = _newest;
+		readSequence = sequence[reading].load(std::memory_order_relaxed);
+		return &slots[reading];
+	}
+
+	//!< Consumer: the slot last returned by acquire(), or NULL
+	const T* current() const{
+		return reading >= 0 ? &slots[reading] : NULL;
+	}
+
+private:
+	enum SLOT_STATE{ FREE, WRITING, READY, READING };
+
+	T slots[2];
+	std::atomic<int> state[2];
+	std::atomic<uint64> sequence[2];	//!< Publish order, written before the slot is marked READY
+
+	int writing = 0;		//!< Producer only
+	uint64 published = 0;	//!< Producer only
+	int reading = -1;		//!< Consumer only
+	uint64 readSequence = 0;	//!< Consumer only
+};
+
+//!< Three slot exchange, neither side ever waits. The producer always has a private back slot to
+//!< write, publishing swaps it with the middle slot, the consumer swaps its front slot with the 
+//!< middle one when something newer was published so it always reads the latest complete state.
+template <typename T>
+class TripleBuffer{
+public:
+	//!< Producer: slot to write the next state into
+	T* writeBuffer() { return &slots[back]; }
+
+	//!< Producer: makes the written slot the latest state
+	void publish(){
+		int _previous = middle.exchange(back | NEW_DATA, std::memory_order_acq_rel);
+		back = _previous & INDEX_MASK;
+	}
+
+	//!< Consumer: returns the latest published state, fresh is set if it changed since the last read
+	const T* read(bool* fresh = NULL){
+		bool _fresh = (middle.load(std::memory_order_relaxed) & NEW_DATA) != 0;
+		if (_fresh){
+			int _previous = middle.exchange(front, std::memory_order_acq_rel);
+			front = _previous & INDEX_MASK;
+		}
+		if (fresh != NULL)
+			*fresh = _fresh;
+		return &slots[front];
+	}
+
+private:
+	enum { INDEX_MASK = 0x3, NEW_DATA = 0x4 };
+
+	T slots[3];
+	std::atomic<int> middle{ 1 };
+	int back = 0;	//!< Producer only
+	int front = 2;	//!< Consumer only
+};
+
+//!< Fixed size single producer/ single consumer ring buffer, Size must be a power of two
+template <typename T, uint32 Size>
+class SpscQueue{
+public:
+	//!< Producer: returns false (and drops the item) if the queue is full
+	bool push(const T& item){
+		uint32 _head = head.load(std::memory_order_relaxed);
+		if (_head - tail.load(std::memory_order_acquire) == Size)
+			return false;
+		items[_head & (Size - 1)] = item;
+		head.store(_head + 1, std::memory_order_release);
+		return true;
+	}
+
+	//!< Consumer: returns false if the queue is empty
+	bool pop(T& item){
+		uint32 _tail = tail.load(std::memory_order_relaxed);
+		if (_tail == head.load(std::memory_order_acquire))
+			return false;
+		item = items[_tail & (Size - 1)];
+		tail.store(_tail + 1, std::memory_order_release);
+		return true;
+	}
+
+private:
+	static_assert((Size & (Size - 1)) == 0, "SpscQueue size must be a power of two");
+
+	T items[Size];
+	std::atomic<uint32> head{ 0 };
+	std::atomic<uint32> tail{ 0 };
+};
@@ -0,0 +1,219 @@
+#include "FrameStreamer.h"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#if defined(_WIN32)
+#include <io.h>
+#include <fcntl.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TETRIS_CONVERT_SSE2
+#endif
+
+namespace{
+
+	// BT.601 limited range, 8 bit fixed point
+	inline uint8 lumaOf(int r, int g, int b){ return (uint8)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16); }
+	inline uint8 chromaUOf(int r, int g, int b){ return (uint8)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128); }
+	inline uint8 chromaVOf(int r, int g, int b){ return (uint8)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128); }
+
+#if defined(TETRIS_CONVERT_SSE2)
+	// Weighted sum of R, G, B for 4 RGBA pixels, coefficients are (r, g, b, 0) repeated twice
+	inline __m128i weightedSums(__m128i pixels, __m128i coefficients){
+		const __m128i _zero = _mm_setzero_si128();
+		__m128i _lo = _mm_madd_epi16(_mm_unpacklo_epi8(pixels, _zero), coefficients);
+		__m128i _hi = _mm_madd_epi16(_mm_unpackhi_epi8(pixels, _zero), coefficients);
+
+		// Each pixel is now r*cr + g*cg and b*cb in neighbouring lanes, add the pairs
+		_lo = _mm_add_epi32(_lo, _mm_srli_epi64(_lo, 32));
+		_hi = _mm_add_epi32(_hi, _mm_srli_epi64(_hi, 32));
+
+		return _mm_unpacklo_epi64(_mm_shuffle_epi32(_lo, _MM_SHUFFLE(3, 1, 2, 0)),
+								  _mm_shuffle_epi32(_hi, _MM_SHUFFLE(3, 1, 2, 0)));
+	}
+
+	// (sums + 128) >> 8 + offset
+	inline __m128i scaleSums(__m128i sums, __m128i offset){
+		return _mm_add_epi32(_mm_srai_epi32(_mm_add_epi32(sums, _mm_set1_epi32(128)), 8), offset);
+	}
+
+	// Averages a 2x2 block for each of the 2 chroma samples covered by 4 pixels, result in lanes 0 + 1
+	inline __m128i averageBlocks(__m128i row0, __m128i row1){
+		__m128i _vertical = _mm_avg_epu8(row0, row1);
+		__m128i _both = _mm_avg_epu8(_vertical, _mm_srli_si128(_vertical, 4));
+		return _mm_shuffle_epi32(_both, _MM_SHUFFLE(3, 1, 2, 0));
+	}
+#endif
+
+}
+
+void rgbaToI420(const uint8* rgba, int width, int height, uint8* yPlane, uint8* uPlane, uint8* vPlane){
+
+	int _chromaWidth = width / 2;
+
+	for (int _y = 0; _y < height; _y += 2){
+		const uint8* _row0 = rgba + (_y * width * 4);
+		const uint8* _row1 = _row0 + (width * 4);
+		uint8* _y0 = yPlane + (_y * width);
+		uint8* _y1 = _y0 + width;
+		uint8* _u = uPlane + ((_y / 2) * _chromaWidth);
+		uint8* _v = vPlane + ((_y / 2) * _chromaWidth);
+
+		int _x = 0;
+
+#if defined(TETRIS_CONVERT_SSE2)
+		const __m128i _coefY = _mm_setr_epi16(66, 129, 25, 0, 66, 129, 25, 0);
+		const __m128i _coefU = _mm_setr_epi16(-38, -74, 112, 0, -38, -74, 112, 0);
+		const __m128i _coefV = _mm_setr_epi16(112, -94, -18, 0, 112, -94, -18, 0);
+		const __m128i _lumaOffset = _mm_set1_epi32(16);
+		const __m128i _chromaOffset = _mm_set1_epi32(128);
+		const __m128i _zero = _mm_setzero_si128();
+
+		// 8 pixels across 2 rows per step, 16 luma + 4 of each chroma sample
+		for (; _x + 8 <= width; _x += 8){
+			__m128i _a0 = _mm_loadu_si128((const __m128i*)(_row0 + (_x * 4)));
+			__m128i _b0 = _mm_loadu_si128((const __m128i*)(_row0 + (_x * 4) + 16));
+			__m128i _a1 = _mm_loadu_si128((const __m128i*)(_row1 + (_x * 4)));
+			__m128i _b1 = _mm_loadu_si128((const __m128i*)(_row1 + (_x * 4) + 16));
+
+			__m128i _luma0 = _mm_packs_epi32(scaleSums(weightedSums(_a0, _coefY), _lumaOffset),
+											 scaleSums(weightedSums(_b0, _coefY), _lumaOffset));
+			__m128i _luma1 = _mm_packs_epi32(scaleSums(weightedSums(_a1, _coefY), _lumaOffset),
+											 scaleSums(weightedSums(_b1, _coefY), _lumaOffset));
+			_mm_storel_epi64((__m128i*)(_y0 + _x), _mm_packus_epi16(_luma0, _zero));
+			_mm_storel_epi64((__m128i*)(_y1 + _x), _mm_packus_epi16(_luma1, _zero));
+
+			__m128i _blocks = _mm_unpacklo_epi64(averageBlocks(_a0, _a1), averageBlocks(_b0, _b1));
+			__m128i _chromaU = _mm_packs_epi32(scaleSums(weightedSums(_blocks, _coefU), _chromaOffset), _zero);
+			__m128i _chromaV = _mm_packs_epi32(scaleSums(weightedSums(_blocks, _coefV), _chromaOffset), _zero);
+			int _packedU = _mm_cvtsi128_si32(_mm_packus_epi16(_chromaU, _zero));
+			int _packedV = _mm_cvtsi128_si32(_mm_packus_epi16(_chromaV, _zero));
+			memcpy(_u + (_x / 2), &_packedU, 4);
+			memcpy(_v + (_x / 2), &_packedV, 4);
+		}
+#endif
+
+		for (; _x < width; _x += 2){
+			const uint8* _p[4] = { _row0 + (_x * 4), _row0 + (_x * 4) + 4, _row1 + (_x * 4), _row1 + (_x * 4) + 4 };
+
+			_y0[_x] = lumaOf(_p[0][0], _p[0][1], _p[0][2]);
+			_y0[_x + 1] = lumaOf(_p[1][0], _p[1][1], _p[1][2]);
+			_y1[_x] = lumaOf(_p[2][0], _p[2][1], _p[2][2]);
+			_y1[_x + 1] = lumaOf(_p[3][0], _p[3][1], _p[3][2]);
+
+			// Same rounding as the SIMD path, rows averaged first then columns
+			int _avg[3];
+			for (int _c = 0; _c < 3; _c++)
+				_avg[_c] = (((_p[0][_c] + _p[2][_c] + 1) >> 1) + ((_p[1][_c] + _p[3][_c] + 1) >> 1) + 1) >> 1;
+			int _r = _avg[0], _g = _avg[1], _b = _avg[2];
+			_u[_x / 2] = chromaUOf(_r, _g, _b);
+			_v[_x / 2] = chromaVOf(_r, _g, _b);
+		}
+	}
+}
+
+bool FrameStreamer::start(const char* path, STREAM_FORMAT _format, int _width, int _height, int fps){
+	format = _format;
+	width = _width;
+	height = _height;
+
+	if (strcmp(path, "-") == 0){
+		file = stdout;
+		ownsFile = false;
+#if defined(_WIN32)
+		_setmode(_fileno(stdout), _O_BINARY);
+#endif
+	}
+	else{
+		file = fopen(path, "wb");
+		ownsFile = true;
+	}
+
+	if (file == NULL){
+		std::cout << "Unable to open stream output: " << path << std::endl;
+		return false;
+	}
+
+	// Everything the stream needs is allocated here, nothing per frame
+	for (uint32 _i = 0; _i < poolSize; _i++){
+		frames[_i].assign(width * height * 4, 0);
+		freeFrames.push((uint8)_i);
+	}
+	yuv.assign((width * height * 3) / 2, 0);
+
+	if (format == STREAM_Y4M)
+		fprintf(file, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", width, height, fps);
+
+	running = true;
+	thread = std::thread(&FrameStreamer::run, this);
+	return true;
+}
+
+void FrameStreamer::stop(){
+	if (!thread.joinable())
+		return;
+
+	running = false;
+	thread.join();
+
+	fflush(file);
+	if (ownsFile)
+		fclose(file);
+	file = NULL;
+}
+
+uint8* FrameStreamer::acquireFrame(bool wait){
+	uint8 _index;
+	while (!freeFrames.pop(_index)){
+		if (!wait){
+			dropped++;
+			return NULL;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	acquired = _index;
+	return &frames[_index][0];
+}
+
+void FrameStreamer::submitFrame(){
+	queuedFrames.push((uint8)acquired);
+	acquired = -1;
+}
+
+void FrameStreamer::run(){
+	for (;;){
+		// Read before popping so frames submitted before stop() are always drained
+		bool _stopping = !running;
+
+		uint8 _index;
+		if (!queuedFrames.pop(_index)){
+			if (_stopping)
+				break;
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			continue;
+		}
+
+		writeFrame(&frames[_index][0]);
+		freeFrames.push(_index);
+		written++;
+	}
+}
+
+void FrameStreamer::writeFrame(const uint8* rgba){
+	if (format == STREAM_RGBA){
+		fwrite(rgba, 1, width * height * 4, file);
+		return;
+	}
+
+	uint8* _yPlane = &yuv[0];
+	uint8* _uPlane = _yPlane + (width * height);
+	uint8* _vPlane = _uPlane + ((width / 2) * (height / 2));
+	rgbaToI420(rgba, width, height, _yPlane, _uPlane, _vPlane);
+
+	fputs("FRAME\n", file);
+	fwrite(&yuv[0], 1, yuv.size(), file);
+}
@@ -0,0 +1,71 @@
+/*Tetris
+Description: Streams rendered frames to a file or pipe as Y4M (I420) or raw RGBA video.
+
+			Frames come from a fixed pool allocated up front, the game copies a finished frame in
+			and submits it, colour conversion and writing happen on a worker thread. In real time
+			mode a frame is dropped rather than waited for when the worker falls behind, so
+			encoding never holds up the simulation.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "Common.h"
+#include "Exchange.h"
+
+enum STREAM_FORMAT{
+	STREAM_Y4M,		//!< YUV4MPEG2, 4:2:0, BT.601 limited range
+	STREAM_RGBA		//!< Raw RGBA frames back to back
+};
+
+//!< Converts RGBA to planar 4:2:0 YUV, width and height must be even
+void rgbaToI420(const uint8* rgba, int width, int height, uint8* yPlane, uint8* uPlane, uint8* vPlane);
+
+class FrameStreamer{
+public:
+	static const uint32 poolSize = 4;
+
+	FrameStreamer() {}
+	~FrameStreamer() { stop(); }
+
+	//!< Opens path ("-" for stdout) and starts the worker, returns false if it can't be opened
+	bool start(const char* path, STREAM_FORMAT format, int width, int height, int fps);
+
+	//!< Writes out any frames still queued, then closes the stream
+	void stop();
+
+	//!< Returns a pool frame (width * height RGBA) to fill, or NULL if none is free and wait is false
+	uint8* acquireFrame(bool wait);
+
+	//!< Queues the frame returned by acquireFrame() for writing
+	void submitFrame();
+
+	uint64 framesWritten() const { return written.load(); }
+	uint64 framesDropped() const { return dropped.load(); }
+
+private:
+	void run();
+	void writeFrame(const uint8* rgba);
+
+	FILE* file = NULL;
+	bool ownsFile = false;
+	STREAM_FORMAT format = STREAM_Y4M;
+	int width = 0;
+	int height = 0;
+
+	std::vector<uint8> frames[poolSize];	//!< The frame pool
+	std::vector<uint8> yuv;					//!< Conversion buffer, worker only
+
+	SpscQueue<uint8, poolSize * 2> freeFrames;		//!< Worker -> game
+	SpscQueue<uint8, poolSize * 2> queuedFrames;	//!< Game -> worker
+	int acquired = -1;
+
+	std::thread thread;
+	std::atomic<bool> running{ false };
+	std::atomic<uint64> written{ 0 };
+	std::atomic<uint64> dropped{ 0 };
+};
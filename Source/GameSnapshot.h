@@ -0,0 +1,21 @@
+/*Tetris
+Description: Copy of everything needed to draw the game, published by the simulation thread.
+*/
+
+#pragma once
+
+#include <vector>
+
+#include "Common.h"
+#include "Engine/Game.h"
+
+struct GameSnapshot{
+	uint8 grid[Game::cellCount] = {};	//!< Grid data, see Game
+	uint8 currentBlock[16] = {};		//!< Falling block layout 
+	Vec2 blockPosition = Vec2(0, 0);	//!< Pivot of the falling block 
+	uint8 currentBlockID = 0;
+	uint64 tick = 0;					//!< Simulation tick the snapshot was taken on
+
+	std::vector<uint8> boards;			//!< Spectator wall games, see genBoardCells
+	int boardCount = 0;
+};
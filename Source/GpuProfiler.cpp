@@ -0,0 +1,104 @@
+#include "GpuProfiler.h"
+
+void GpuProfiler::init(){
+	glGenQueries(2 * GPU_STAGE_COUNT, &queries[0][0]);
+	initialised = true;
+}
+
+void GpuProfiler::shutdown(){
+	if (!initialised)
+		return;
+
+	glDeleteQueries(2 * GPU_STAGE_COUNT, &queries[0][0]);
+	initialised = false;
+}
+
+bool GpuProfiler::openCsv(const char* path){
+	closeCsv();
+	csv = fopen(path, "w");
+	if (csv == NULL)
+		return false;
+
+	fprintf(csv, "frame");
+	for (int _s = 0; _s < GPU_STAGE_COUNT; _s++)
+		fprintf(csv, ",%s_ms", stageName((GPU_STAGE)_s));
+	fprintf(csv, "\n");
+	return true;
+}
+
+void GpuProfiler::closeCsv(){
+	if (csv != NULL)
+		fclose(csv);
+	csv = NULL;
+}
+
+void GpuProfiler::beginFrame(){
+	if (!initialised)
+		return;
+
+	int _set = frame & 1;
+
+	// Results are only read when already available, otherwise the frame is skipped. 
+	// Stages that were not drawn this frame count as 0.
+	bool _ready = false;
+	for (int _s = 0; _s < GPU_STAGE_COUNT; _s++){
+		if (!issued[_set][_s])
+			continue;
+		GLint _available = 0;
+		glGetQueryObjectiv(queries[_set][_s], GL_QUERY_RESULT_AVAILABLE, &_available);
+		_ready = _available != 0;
+		if (!_ready)
+			break;
+	}
+
+	if (_ready){
+		double _ms[GPU_STAGE_COUNT];
+		for (int _s = 0; _s < GPU_STAGE_COUNT; _s++){
+			GLuint64 _ns = 0;
+			if (issued[_set][_s])
+				glGetQueryObjectui64v(queries[_set][_s], GL_QUERY_RESULT, &_ns);
+			_ms[_s] = _ns / 1000000.0;
+			stats[_s].add(_ms[_s]);
+		}
+
+		if (csv != NULL){
+			fprintf(csv, "%llu", (unsigned long long)frameNumber[_set]);
+			for (int _s = 0; _s < GPU_STAGE_COUNT; _s++)
+				fprintf(csv, ",%.4f", _ms[_s]);
+			fprintf(csv, "\n");
+		}
+	}
+	else if (frame >= 2){
+		missed++;
+	}
+
+	for (int _s = 0; _s < GPU_STAGE_COUNT; _s++)
+		issued[_set][_s] = false;
+	frameNumber[_set] = frame;
+}
+
+void GpuProfiler::endFrame(){
+	frame++;
+}
+
+void GpuProfiler::begin(GPU_STAGE stage){
+	if (initialised)
+		glBeginQuery(GL_TIME_ELAPSED, queries[frame & 1][stage]);
+}
+
+void GpuProfiler::end(GPU_STAGE stage){
+	if (!initialised)
+		return;
+
+	glEndQuery(GL_TIME_ELAPSED);
+	issued[frame & 1][stage] = true;
+}
+
+const char* GpuProfiler::stageName(GPU_STAGE stage){
+	switch (stage){
+	case GPU_UPLOAD: return "upload";
+	case GPU_DRAW: return "draw";
+	case GPU_SWAP: return "swap";
+	default: return "unknown";
+	}
+}
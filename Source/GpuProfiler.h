@@ -0,0 +1,67 @@
+/*Tetris
+Description: GPU timings for each stage of a frame using GL_TIME_ELAPSED queries.
+
+			Two sets of queries are used in turn, results for a set are read back the next time 
+			it comes around (two frames later) and only if the driver says they are available, so
+			collecting them never stalls the pipeline. Must only be used on the thread that owns
+			the GL context.
+*/
+
+#pragma once
+
+#include <cstdio>
+
+#include <GL/glew.h>
+
+#include "Common.h"
+#include "RollingStats.h"
+
+enum GPU_STAGE{
+	GPU_UPLOAD,		//!< genBlockBuffer data to the vertex buffer 
+	GPU_DRAW,		//!< glDrawArrays for the blocks 
+	GPU_SWAP,		//!< SDL_GL_SwapWindow
+	GPU_STAGE_COUNT
+};
+
+class GpuProfiler{
+public:
+	static const uint32 window = 120;	//!< Frames in the rolling report
+
+	GpuProfiler() {}
+	~GpuProfiler() { closeCsv(); }
+
+	//!< Creates the query objects, needs a current context
+	void init();
+	void shutdown();
+
+	//!< Writes a row per collected frame to path, returns false if it can't be opened
+	bool openCsv(const char* path);
+	void closeCsv();
+
+	//!< Collects whatever finished from the set about to be reused
+	void beginFrame();
+	void endFrame();
+
+	void begin(GPU_STAGE stage);
+	void end(GPU_STAGE stage);
+
+	//!< Rolling summary in ms
+	StatsSummary summary(GPU_STAGE stage) const { return stats[stage].summary(); }
+
+	//!< Frames whose results were not ready in time and were skipped
+	uint64 missedFrames() const { return missed; }
+
+	static const char* stageName(GPU_STAGE stage);
+
+private:
+	GLuint queries[2][GPU_STAGE_COUNT] = {};
+	bool issued[2][GPU_STAGE_COUNT] = {};
+	uint64 frameNumber[2] = {};
+
+	uint64 frame = 0;
+	uint64 missed = 0;
+	bool initialised = false;
+
+	RollingStats<window> stats[GPU_STAGE_COUNT];
+	FILE* csv = NULL;
+};
@@ -0,0 +1,76 @@
+#include "Hud.h"
+
+namespace{
+
+	// 3x5 glyphs, one row of 3 pixels per argument top row first, written as binary digits (101 etc.)
+	#define ROW(b) ((((b) / 100) << 2) | ((((b) / 10) % 10) << 1) | ((b) % 10))
+	#define GLYPH(r0, r1, r2, r3, r4) ((ROW(r0) << 12) | (ROW(r1) << 9) | (ROW(r2) << 6) | (ROW(r3) << 3) | ROW(r4))
+
+	struct Glyph{
+		char character;
+		uint16 rows;
+	};
+
+	const Glyph font[] = {
+		{ '0', GLYPH(111, 101, 101, 101, 111) }, { '1', GLYPH(10, 110, 10, 10, 111) },
+		{ '2', GLYPH(111, 1, 111, 100, 111) }, { '3', GLYPH(111, 1, 111, 1, 111) },
+		{ '4', GLYPH(101, 101, 111, 1, 1) }, { '5', GLYPH(111, 100, 111, 1, 111) },
+		{ '6', GLYPH(111, 100, 111, 101, 111) }, { '7', GLYPH(111, 1, 1, 1, 1) },
+		{ '8', GLYPH(111, 101, 111, 101, 111) }, { '9', GLYPH(111, 101, 111, 1, 111) },
+		{ 'A', GLYPH(10, 101, 111, 101, 101) }, { 'B', GLYPH(110, 101, 110, 101, 110) },
+		{ 'C', GLYPH(11, 100, 100, 100, 11) }, { 'D', GLYPH(110, 101, 101, 101, 110) },
+		{ 'E', GLYPH(111, 100, 110, 100, 111) }, { 'F', GLYPH(111, 100, 110, 100, 100) },
+		{ 'G', GLYPH(11, 100, 101, 101, 11) }, { 'H', GLYPH(101, 101, 111, 101, 101) },
+		{ 'I', GLYPH(111, 10, 10, 10, 111) }, { 'J', GLYPH(1, 1, 1, 101, 10) },
+		{ 'K', GLYPH(101, 101, 110, 101, 101) }, { 'L', GLYPH(100, 100, 100, 100, 111) },
+		{ 'M', GLYPH(101, 111, 111, 101, 101) }, { 'N', GLYPH(110, 101, 101, 101, 101) },
+		{ 'O', GLYPH(10, 101, 101, 101, 10) }, { 'P', GLYPH(110, 101, 110, 100, 100) },
+		{ 'Q', GLYPH(10, 101, 101, 110, 11) }, { 'R', GLYPH(110, 101, 110, 101, 101) },
+		{ 'S', GLYPH(11, 100, 10, 1, 110) }, { 'T', GLYPH(111, 10, 10, 10, 10) },
+		{ 'U', GLYPH(101, 101, 101, 101, 111) }, { 'V', GLYPH(101, 101, 101, 101, 10) },
+		{ 'W', GLYPH(101, 101, 111, 111, 101) }, { 'X', GLYPH(101, 101, 10, 101, 101) },
+		{ 'Y', GLYPH(101, 101, 10, 10, 10) }, { 'Z', GLYPH(111, 1, 10, 100, 111) },
+		{ '.', GLYPH(0, 0, 0, 0, 10) }, { ':', GLYPH(0, 10, 0, 10, 0) },
+		{ '-', GLYPH(0, 0, 111, 0, 0) }, { '/', GLYPH(1, 1, 10, 100, 100) },
+		{ '%', GLYPH(101, 1, 10, 100, 101) }, { '=', GLYPH(0, 111, 0, 111, 0) },
+		{ '(', GLYPH(10, 100, 100, 100, 10) }, { ')', GLYPH(10, 1, 1, 1, 10) },
+	};
+
+	uint16 glyphRows(char character){
+		if (character >= 'a' && character <= 'z')
+			character = character - 'a' + 'A';
+
+		for (size_t _i = 0; _i < sizeof(font) / sizeof(font[0]); _i++){
+			if (font[_i].character == character)
+				return font[_i].rows;
+		}
+		return 0; // Space/ unknown
+	}
+
+}
+
+void Hud::addQuad(float x, float y, float size){
+	if ((int)vertices.size() < vertBufferSize + 18)
+		vertices.resize((vertBufferSize + 18) * 2);
+
+	float* _v = &vertices[vertBufferSize];
+	const float _quad[6][2] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 0 }, { 1, 1 }, { 0, 1 } };
+	for (int _i = 0; _i < 6; _i++){
+		_v[(_i * 3) + 0] = x + (_quad[_i][0] * size);
+		_v[(_i * 3) + 1] = y + (_quad[_i][1] * size);
+		_v[(_i * 3) + 2] = 0;
+	}
+	vertBufferSize += 18;
+}
+
+void Hud::print(float x, float y, float scale, const char* text){
+	for (; *text != 0; text++, x += 4 * scale){
+		uint16 _rows = glyphRows(*text);
+		for (int _row = 0; _row < 5; _row++){
+			for (int _column = 0; _column < 3; _column++){
+				if (_rows & (1 << (((4 - _row) * 3) + (2 - _column))))
+					addQuad(x + (_column * scale), y + (_row * scale), scale);
+			}
+		}
+	}
+}
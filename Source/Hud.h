@@ -0,0 +1,33 @@
+/*Tetris
+Description: Builds on screen debug text as solid quads from a built in 3x5 pixel font.
+
+			Only builds vertex data (3 floats per vertex, screen pixels with the origin top left),
+			drawing it is up to the renderer. Lower case is drawn as upper case.
+*/
+
+#pragma once
+
+#include <vector>
+
+#include "Common.h"
+
+class Hud{
+public:
+	//!< Removes all text, keeps the buffer
+	void clear() { vertBufferSize = 0; }
+
+	//!< Adds a line of text at x, y (pixels), each font pixel is scale x scale screen pixels
+	void print(float x, float y, float scale, const char* text);
+
+	//!< Height of a line of text including spacing
+	static float lineHeight(float scale) { return 7 * scale; }
+
+	const float* vertexData() const { return vertices.empty() ? NULL : &vertices[0]; }
+	int vertexFloats() const { return vertBufferSize; }
+
+private:
+	void addQuad(float x, float y, float size);
+
+	std::vector<float> vertices;
+	int vertBufferSize = 0;
+};
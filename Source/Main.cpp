@@ -31,6 +31,9 @@ Description: Subset of features/ demonstration, just out of the blue wanted to w
 #include <SDL2/SDL_image.h>
 
 #include <random>
+#include <atomic>
+#include <cstring>
+#include <algorithm>
 #include <time.h>
 
 //Include the glm headers 
@@ -38,96 +41,37 @@ Description: Subset of features/ demonstration, just out of the blue wanted to w
 #include "glm/gtc/matrix_transform.hpp"
 #include <glm/gtc/type_ptr.hpp>
 
-//Define some useful types
-typedef unsigned char uint8;
-typedef signed char	sint8; 
-typedef unsigned short uint16; 
-typedef signed short sint16; 
-typedef unsigned int uint32; 
-typedef signed int sint32; 
-
-class Vec2{
-public:
-	Vec2(int _x, int _y) { x = _x; y = _y; }
-	signed int x; 
-	signed int y; 
-};
+#include "Common.h"
+#include "ShaderCache.h"
+#include "DrawList.h"
+#include "RenderThread.h"
+#include "SimulationThread.h"
+#include "GameSnapshot.h"
+#include "SoftwareRenderer.h"
+#include "FrameStreamer.h"
+#include "GpuProfiler.h"
+#include "Hud.h"
+#include "SpectatorWall.h"
+#include "SpectatorServer.h"
+#include "VersusPeer.h"
+#include "Profiler.h"
+#include "Engine/Trace.h"
+#include "Engine/Game.h"
+#include "Engine/Bot.h"
 
 //!< Global Variables 
 SDL_Window* window;
-bool gameRunning = true; 
+std::atomic<bool> gameRunning{ true }; 
 
 //!< Game properties 
-Vec2 gridSize(12, 22);
+Vec2 gridSize(Game::width, Game::height);
 Vec2 windowSize(1280, 720);
 
-//Block types enumeration 
-/**
-	Standard game of tetris consists of 7 blocks
-	Naught == Empty 
-*/
-	//Inspiring names... 
-enum BLOCK_TYPE{
-	EMPTY = 0x0,
-	BLOCK1 = 0x1 << 0, // Square 
-	BLOCK2 = 0x1 << 1, // Line 
-	BLOCK3 = 0x1 << 2, 
-	BLOCK4 = 0x1 << 3, 
-	BLOCK5 = 0x1 << 4, 
-	BLOCK6 = 0x1 << 5,
-	BLOCK7 = 0x1 << 6, 
-	WALL = 0x1 << 7
-};
-
-//!< Array to hold grid data
-uint8 grid[12 * 22];
-
-//!< Array to hold blocks 
-//!< Rather than come up with an eloborate algorithm I've stored the rotations within the arrays
-//!< 7 blocks, 4 animations, 4x4 grid 
-uint8 Block[7][16] = {
-	
-  { 1, 1, 0, 0, 
-	1, 1, 0, 0,
-	0, 0, 0, 0,
-	0, 0, 0, 0 },
-	
-	{0, 0, 0, 0,
-	 1, 1, 1, 1,
-	 0, 0, 0, 0,
-	 0, 0, 0, 0},
-
-	{1, 0, 0, 0,
-	 1, 1, 1, 0,
-	 0, 0, 0, 0,
-	 0, 0, 0, 0 },
-
-	{0, 0, 1, 0,
-	 1, 1, 1, 0,
-	 0, 0, 0, 0,
-	 0, 0, 0, 0 },
-
-	{0, 0, 0, 0,
-	 1, 1, 1, 0,
-	 0, 1, 0, 0,
-	 0, 0, 0, 0 },
-
-	{0, 1, 1, 0,
-	 1, 1, 0, 0,
-	 0, 0, 0, 0,
-	 0, 0, 0, 0 },
-
-	{1, 1, 0, 0,
-	 0, 1, 1, 0,
-	 0, 0, 0, 0,
-	 0, 0, 0, 0 }
-
-};
+//!< The game being played, rules live in the engine 
+Game game; 
 
-uint8 currentBlock[] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
-Vec2 blockPosition(0, 0);
-uint8 currentBlockType = 0; 
-uint8 currentBlockID = 0;
+//!< Plays instead of the keyboard when set (--bot), simulation thread only 
+Bot* bot = NULL; 
 
 // The camera distance in the scene, hardcoded for simplicity, it is tetris afterall 
 float camZDist = 20; 
@@ -135,18 +79,9 @@ float camZDist = 20;
 // Define our view and projection martices 
 glm::mat4 viewMat, projMat; 
 
-// Buffer for grid outline
-std::vector <float> gridLinesVertices; 
-GLuint gridVBO;		//!< Vertex buffer object used by grid 
-GLuint gridLinesID; 
-GLuint gridPositions; //atrib pointer
-
-// Buffers to hold vertex data for blocks
-int _vertBufferSize;
-int _texBufferSize;
-
-std::vector <float>	vertices; //!< Holds vertex positions  
-std::vector <float> textureCoords; //<! Holds texture coordinates 
+// Vertex data for blocks is built into draw lists and handed to the render thread 
+RenderThread renderThread; 
+uint32 frameCount = 0; 
 
 // Buffer Ids 
 GLuint vertexBufferID;	//!< Position buffer ID
@@ -158,32 +93,76 @@ GLint texAtribLocation;
 // Shader program we will use for EVERYTHING
 GLuint program;
 
+// Linked program binary is cached here between runs 
+const char* shaderCachePath = "shader.cache";
+ShaderCacheStats shaderStats; 
+
 // Uniform locations 
 GLint _useColour; 
+GLint _solidColour; 
+GLint _wvpMat; 
+
+// GPU time per render stage, shown with F2 
+GpuProfiler gpuProfiler; 
+std::atomic<bool> showGpuOverlay{ false }; 
+
+#ifdef TETRIS_PROFILE
+// CPU time per stage, shown with F3 
+std::atomic<bool> showCpuHud{ false }; 
+#endif
+
+#ifdef TETRIS_TRACE
+// Where F4 writes the trace of the last few seconds, --trace also writes it on exit 
+const char* tracePath = "trace.json"; 
+#endif
+
+// Tournament hall display, draws wallBoards boards instead of the single game when > 0 
+SpectatorWall spectatorWall; 
+int wallBoards = 0; 
+std::vector<Game> wallGames;	//!< Independent games shown on the wall, simulation thread only 
+
+// Live game for spectators on other machines/ processes, publishing is a no op unless started 
+SpectatorServer spectatorServer; 
+
+// Two player match over UDP (--versus-port), the wall shows both boards while it runs 
+RollbackSession* versus = NULL; 
+VersusPeer versusPeer; 
+float versusElapsed = 0; 
+uint8 versusInput = 0;			//!< Taps since the last versus frame, simulation thread only 
+
+// Debug text, drawn in screen space 
+Hud hud; 
+GLuint hudBufferID; 
 
 // Textures 
 GLuint blockTexture; 
 
-//How fast the blocks drop ms
-uint16 blockDropDefault = 600; // Level 1 value 
-uint16 blockDropFaster = 30;
-uint16 blockDropMS = 600; 
-float blockDropedElapsed = 0; 
-float previousTimeElapsed = 0; 
-
 float inputElapsed = 0; 
 float inputDelayMS = 0; 
 
+//!< Game logic runs on its own thread at a fixed rate 
+const uint32 simulationRate = 1000; 
+SimulationThread simulationThread; 
+
+//!< Latest game state for the renderer, written by the simulation thread only 
+TripleBuffer<GameSnapshot> snapshots; 
+
+//!< Input gathered on the main thread, applied on the simulation thread 
+enum INPUT_COMMAND{
+	INPUT_ROTATE, 
+	INPUT_LEFT, 
+	INPUT_RIGHT
+};
+SpscQueue<uint8, 64> inputCommands; 
+std::atomic<bool> softDrop{ false }; 
+
 // pre - declarations 
-void rotateBlock(); 
-void moveLeft(); 
-void moveRight(); 
 int loadTexture(const char* FilePath);
 
-//Handles input
+//Handles input, runs on the main thread as SDL events have to be handled there 
 void poll(){
-
-	inputElapsed += SDL_GetTicks() - previousTimeElapsed;
+		PROFILE_SCOPE(CPU_POLL);
+		TRACE_SCOPE("poll");
 		
 		SDL_Event _event;
 		const Uint8 *keyState = SDL_GetKeyboardState(NULL);
@@ -194,42 +173,124 @@ void poll(){
 			}
 
 			if (keyState[SDL_SCANCODE_SPACE]){
-				if (inputElapsed > inputDelayMS){
-					inputElapsed = 0;
-					rotateBlock();
-				}
+				inputCommands.push(INPUT_ROTATE);
 			}
 
 			if (keyState[SDL_SCANCODE_LEFT]){
-				moveLeft();
+				inputCommands.push(INPUT_LEFT);
 			}
 
 			if (keyState[SDL_SCANCODE_RIGHT]){
-				moveRight(); 
+				inputCommands.push(INPUT_RIGHT);
+			}
+
+			softDrop = keyState[SDL_SCANCODE_DOWN] != 0;
+
+			if (_event.type == SDL_KEYDOWN && _event.key.keysym.scancode == SDL_SCANCODE_F2 && !_event.key.repeat){
+				showGpuOverlay = !showGpuOverlay;
 			}
 
-			if (keyState[SDL_SCANCODE_DOWN]){
-				blockDropMS = blockDropFaster;
+#ifdef TETRIS_PROFILE
+			if (_event.type == SDL_KEYDOWN && _event.key.keysym.scancode == SDL_SCANCODE_F3 && !_event.key.repeat){
+				showCpuHud = !showCpuHud;
 			}
-			else{
-				//set drop speed back to current 
-				blockDropMS = blockDropDefault; // - level * somevalue
+#endif
+
+#ifdef TETRIS_TRACE
+			if (_event.type == SDL_KEYDOWN && _event.key.keysym.scancode == SDL_SCANCODE_F4 && !_event.key.repeat){
+				int _events = traceFlush(tracePath);
+				if (_events < 0)
+					std::cout << "Unable to write " << tracePath << std::endl;
+				else
+					std::cout << "Trace: " << _events << " events written to " << tracePath << std::endl;
 			}
-			
+#endif
 		}
 	
 }
 
+// Applies the input gathered by poll(), runs on the simulation thread 
+void applyInput(float tickMS){
+
+	inputElapsed += tickMS;
+
+	uint8 _command;
+	if (versus != NULL){
+		// Played through the session a frame at a time, the game itself is not touched 
+		while (inputCommands.pop(_command)){
+			if (_command == INPUT_ROTATE)
+				versusInput |= VERSUS_ROTATE;
+			else if (_command == INPUT_LEFT)
+				versusInput |= VERSUS_LEFT;
+			else if (_command == INPUT_RIGHT)
+				versusInput |= VERSUS_RIGHT;
+		}
+		return;
+	}
+
+	if (bot != NULL){
+		// Keys are ignored while the bot plays 
+		while (inputCommands.pop(_command)) {}
+		bot->drive(game, tickMS);
+		return;
+	}
+
+	while (inputCommands.pop(_command)){
+		switch (_command){
+		case INPUT_ROTATE:
+			if (inputElapsed > inputDelayMS){
+				inputElapsed = 0;
+				game.rotateBlock();
+			}
+			break;
+		case INPUT_LEFT:
+			game.moveLeft();
+			break;
+		case INPUT_RIGHT:
+			game.moveRight();
+			break;
+		}
+	}
+
+	game.setSoftDrop(softDrop);
+}
+
 void glCheck(){
 	GLuint err = glGetError();
 	if (err != GL_NO_ERROR)
 		std::cerr << std::hex << err << std::endl;
 }
 
-void loadShaders(){
-	GLuint vShader = glCreateShader(GL_VERTEX_SHADER);
-	GLuint fShader = glCreateShader(GL_FRAGMENT_SHADER);
+//!< Startup profile, records how long each stage of start up took 
+Uint64 startupStageStart = 0; 
+std::vector<std::pair<const char*, double>> startupStages; 
+
+void startupStage(const char* name){
+	Uint64 _now = SDL_GetPerformanceCounter();
+	double _ms = (double)(_now - startupStageStart) * 1000.0 / SDL_GetPerformanceFrequency();
+	startupStages.push_back(std::make_pair(name, _ms));
+	startupStageStart = _now;
+}
+
+void printStartupProfile(){
+	double _total = 0; 
+	std::cout << "Startup profile:" << std::endl;
+	for (size_t _i = 0; _i < startupStages.size(); _i++){
+		std::cout << "  " << startupStages[_i].first << ": " << startupStages[_i].second << "ms" << std::endl;
+		_total += startupStages[_i].second;
+	}
+	std::cout << "  total: " << _total << "ms" << std::endl;
+
+	if (shaderStats.cacheHit){
+		std::cout << "  shaders: cache hit, " << shaderStats.loadMS << "ms (compile took " 
+			<< shaderStats.compileMS << "ms, saved " << shaderStats.savedMS << "ms)" << std::endl;
+	}
+	else{
+		std::cout << "  shaders: compiled, " << shaderStats.compileMS << "ms" << std::endl;
+	}
+}
 
+void loadShaders(){
 	std::string vertexShader =
 		"#version 330 core \n "
 		"layout (location = 0) in vec4 Vertex;"
@@ -237,8 +298,10 @@ void loadShaders(){
 		"uniform mat4 wvpMat;"
 		//"out vec2 texCoord;"
 		"varying vec2 texCoord;"
+		"out vec2 worldPos;"
 		"void main(){"
 		"	texCoord = texCoordAtrib;"
+		"	worldPos = Vertex.xy;"
 		"	gl_Position = wvpMat * Vertex;"
 		"}";
 
@@ -246,46 +309,22 @@ void loadShaders(){
 		"#version 330 core  \n "
 		"uniform sampler2D tex;"
 		"uniform bool useColour;"
+		"uniform vec4 solidColour;"
 		"in vec2 texCoord;"
+		"in vec2 worldPos;"
 		"layout (location = 0) out vec4 colour;"
+		// Board background (negative tex coords), 1 pixel grid lines on every cell edge
+		"vec4 gridLines(){"
+		"	vec2 edge = abs(fract(worldPos - 0.5) - 0.5) / fwidth(worldPos);"
+		"	float line = 1.0 - min(min(edge.x, edge.y), 1.0);"
+		"	return vec4(0, 0, line, 1);"
+		"}"
 		"void main(){"
-		" if (useColour){colour = vec4(0,0,1,1);} else{colour = texture(tex, texCoord);}"
+		" if (useColour){colour = solidColour;} else if (texCoord.x < 0.0){colour = gridLines();} else{colour = texture(tex, texCoord);}"
 		"}";
 
-	const char* vertSource = vertexShader.c_str();
-	const char* fragSource = fragmentShader.c_str();
-
-	glShaderSource(vShader, 1, &vertSource, NULL);
-	glCompileShader(vShader);
-	glShaderSource(fShader, 1, &fragSource, NULL); 
-	glCompileShader(fShader);
-
-	// Check if shaders compiled successfully 
-	GLint success = 0;
-	glGetShaderiv(vShader, GL_COMPILE_STATUS, &success);
-	if (success == GL_FALSE){
-		GLint logSize = 0;
-		
-		glGetShaderiv(vShader, GL_INFO_LOG_LENGTH, &logSize);
-		char* log = new char[4000]; 
-		GLsizei length;
-		glGetShaderInfoLog(vShader, 4000, &length, log);
-		std::cout << "Vertex Shader Failed: " << log<< std::endl; 
-	}
-	glGetShaderiv(fShader, GL_COMPILE_STATUS, &success);
-	if (success == GL_FALSE){
-		GLint logSize = 0;
-		glGetShaderiv(vShader, GL_INFO_LOG_LENGTH, &logSize);
-		char* log = new char[4000];
-		GLsizei length;
-		glGetShaderInfoLog(fShader, 4000, &length, log);
-		std::cout << "Frag Shader Failed" << log << std::endl;
-	}
-
-	program = glCreateProgram(); 
-	glAttachShader(program, vShader);
-	glAttachShader(program, fShader);
-	glLinkProgram(program);
+	// Linked program comes from the binary cache when the driver + source match
+	program = loadCachedProgram(shaderCachePath, vertexShader, fragmentShader, &shaderStats);
 
 	glUseProgram(program);
 
@@ -293,13 +332,15 @@ void loadShaders(){
 	glBindAttribLocation(program, 0, "Vertex");
 	glBindAttribLocation(program, 1, "texCoordAtrib");
 
-	GLint _wvpMat = glGetUniformLocation(program, "wvpMat");
+	_wvpMat = glGetUniformLocation(program, "wvpMat");
 	GLint _texture = glGetUniformLocation(program, "tex");
 	_useColour = glGetUniformLocation(program, "useColour");
+	_solidColour = glGetUniformLocation(program, "solidColour");
 
 	glUniformMatrix4fv(_wvpMat, 1, false, glm::value_ptr(projMat * viewMat ));
 	glUniform1i(_texture, 0);
 	glUniform1i(_useColour, 0);
+	glUniform4f(_solidColour, 0, 0, 1, 1);
 
 
 }
@@ -321,45 +362,12 @@ void init(){
 
 	// Set viewport
 	glViewport(0, 0, w, h);
-	
-	//Set grid to naught 
-	for (int _g = 0; _g < gridSize.x*gridSize.y; _g++){
-		grid[_g] = 0; 
-	}
-
-	//initialise grid lines array 
-
-	// Resize vector for our data, each point is represented
-	// (vertex)3 floats * 2 vertex per line * total gridlines 
-	gridLinesVertices.resize((3 * 2)*(gridSize.x + gridSize.y));
-
-	for (int _x = 0; _x < gridSize.x; _x++){
-		gridLinesVertices[(_x * 6)] = (-(gridSize.x/2)) + _x;							
-		gridLinesVertices[(_x * 6) + 1] = gridSize.y / 2;			
-		gridLinesVertices[(_x * 6) + 2] = 0.0f;						
-		gridLinesVertices[(_x * 6) + 3] = (-(gridSize.x / 2)) + _x;
-		gridLinesVertices[(_x * 6) + 4] = -(gridSize.y / 2);		
-		gridLinesVertices[(_x * 6) + 5] = 0.0f;						
-	}
-	for (int _y = 0; _y < gridSize.y; _y++){
-		gridLinesVertices[(gridSize.x * 6) + (_y * 6)] = -(gridSize.x/2);							
-		gridLinesVertices[(gridSize.x * 6) + (_y * 6) + 1] = (-(gridSize.y / 2)) + _y;		
-		gridLinesVertices[(gridSize.x * 6) + (_y * 6) + 2] = 0.0f;					
-		gridLinesVertices[(gridSize.x * 6) + (_y * 6) + 3] = gridSize.x / 2;
-		gridLinesVertices[(gridSize.x * 6) + (_y * 6) + 4] = (-(gridSize.y / 2)) + _y;
-		gridLinesVertices[(gridSize.x * 6) + (_y * 6) + 5] = 0.0f; 
-	}
 
-	//glGenVertexArrays(1, &gridVBO);
-	//glBindVertexArray(gridVBO);
-
-	glGenBuffers(1, &gridLinesID);
 	glGenBuffers(1, &vertexBufferID);
 	glGenBuffers(1, &texBufferID);
+	glGenBuffers(1, &hudBufferID);
 
-	glBindBuffer(GL_ARRAY_BUFFER, gridLinesID);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(float) * gridLinesVertices.size(), 
-									&gridLinesVertices[0], GL_STATIC_DRAW);
+	gpuProfiler.init();
 
 	//load textures 
 	blockTexture = loadTexture("blocks.png"); //!< Texture for all blocks 
@@ -367,447 +375,233 @@ void init(){
 
 	//Load our shaders 
 	loadShaders();
-	
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
-	glEnableVertexAttribArray(0);
 
-	vertices.resize(((gridSize.x*gridSize.y)*(3*6)));
-	textureCoords.resize((gridSize.x*gridSize.y) * 12);
-	std::fill(vertices.begin(), vertices.end(), 0);
-	std::fill(textureCoords.begin(), textureCoords.end(), 0);
-	
-	// Set bricks at side 
-	for (uint8 _gridY = 0; _gridY < gridSize.y; _gridY++){
-		grid[_gridY*gridSize.x] = 8; 
-		grid[(_gridY*gridSize.x) + (gridSize.x - 1)] = 8; 
+	if (wallBoards > 0 && !spectatorWall.init(blockTexture, gridSize, windowSize)){
+		std::cout << "Spectator wall unavailable, drawing the single game" << std::endl;
+		wallBoards = 0; 
 	}
-
-}
-
-// Generates/ regenerates the buffer for the blocks in the grid 
-void genBlockBuffer(){
-
-	//Top left quardinates 
-	Vec2 tLeft(-(float)gridSize.x / 2, (float)gridSize.y / 2);
-
-	_vertBufferSize = 0; 
-	_texBufferSize = 0; 
 	
-	uint16 _blockCoords[16];
-
-	// Assign vertices for current block 
-	for (uint8 p = 0; p < 4; p++){
-		for (uint8 q = 0; q < 4; q++){
-			if (currentBlock[(q * 4) + p] == 1){
-				uint8 _gridX = blockPosition.x - 1 + p;
-				uint8 _gridY = blockPosition.y - 1 + q;
-
-				// If  outside grid bounds 
-				if (_gridX < 0 || _gridY < 0)
-					continue;
-
-				float _texWidth = 1.0f / 8;
-				float _texStartX = currentBlockID * _texWidth;
-
-				// Every three represents a vertex 
-				textureCoords[_texBufferSize + 0] = _texStartX;
-				textureCoords[_texBufferSize + 1] = 1;
-				textureCoords[_texBufferSize + 2] = _texStartX + _texWidth;
-				textureCoords[_texBufferSize + 3] = 1;
-				textureCoords[_texBufferSize + 4] = _texStartX + _texWidth;
-				textureCoords[_texBufferSize + 5] = 0;
-				textureCoords[_texBufferSize + 6] = _texStartX;
-				textureCoords[_texBufferSize + 7] = 0;
-				textureCoords[_texBufferSize + 8] = _texStartX;
-				textureCoords[_texBufferSize + 9] = 1;
-				textureCoords[_texBufferSize + 10] = _texStartX + _texWidth;
-				textureCoords[_texBufferSize + 11] = 0;
-
-				vertices[_vertBufferSize + 0] = tLeft.x + _gridX;
-				vertices[_vertBufferSize + 1] = tLeft.y - _gridY;
-				
-				vertices[_vertBufferSize + 3] = tLeft.x + _gridX + 1;
-				vertices[_vertBufferSize + 4] = tLeft.y - _gridY;
-
-				vertices[_vertBufferSize + 6] = tLeft.x + _gridX + 1;
-				vertices[_vertBufferSize + 7] = tLeft.y - _gridY - 1;
-
-				vertices[_vertBufferSize + 9] = tLeft.x + _gridX;
-				vertices[_vertBufferSize + 10] = tLeft.y - _gridY - 1;
-
-				vertices[_vertBufferSize + 12] = tLeft.x + _gridX;
-				vertices[_vertBufferSize + 13] = tLeft.y - _gridY;
-
-				vertices[_vertBufferSize + 15] = tLeft.x + _gridX + 1;
-				vertices[_vertBufferSize + 16] = tLeft.y - _gridY - 1;
-
-				_vertBufferSize += 18;
-				_texBufferSize += 12; 
-
-			}
-
-		}
-	}
-
-	// Calculate new buffer size and prepare vertex array
-	for (int x = 0; x < gridSize.x; x++){
-		for (int y = 0; y < gridSize.y; y++){
-
-			if (grid[(y*gridSize.x) + x] > 0 ){
-	
-				float _texWidth = 1.0f / 8;
-				float _texStartX = (grid[(y*gridSize.x) + x]-1) * _texWidth;
-
-				// Every three represents a vertex 
-				textureCoords[_texBufferSize + 0] = _texStartX;
-				textureCoords[_texBufferSize + 1] = 1;
-				textureCoords[_texBufferSize + 2] = _texStartX + _texWidth;
-				textureCoords[_texBufferSize + 3] = 1;
-				textureCoords[_texBufferSize + 4] = _texStartX + _texWidth;
-				textureCoords[_texBufferSize + 5] = 0;
-				textureCoords[_texBufferSize + 6] = _texStartX;
-				textureCoords[_texBufferSize + 7] = 0;
-				textureCoords[_texBufferSize + 8] = _texStartX;
-				textureCoords[_texBufferSize + 9] = 1;
-				textureCoords[_texBufferSize + 10] = _texStartX + _texWidth;
-				textureCoords[_texBufferSize + 11] = 0;
-
-				// Every three represents a vertex 
-				vertices[_vertBufferSize + 0] = tLeft.x + x;
-				vertices[_vertBufferSize + 1] = tLeft.y - y;
-
-				vertices[_vertBufferSize + 3] = tLeft.x + x + 1;
-				vertices[_vertBufferSize + 4] = tLeft.y - y;
-
-				vertices[_vertBufferSize + 6] = tLeft.x + x + 1;
-				vertices[_vertBufferSize + 7] = tLeft.y - y - 1;
-
-				vertices[_vertBufferSize + 9] = tLeft.x + x;
-				vertices[_vertBufferSize + 10] = tLeft.y - y - 1;
-
-				vertices[_vertBufferSize + 12] = tLeft.x + x;
-				vertices[_vertBufferSize + 13] = tLeft.y - y;
-
-				vertices[_vertBufferSize + 15] = tLeft.x + x + 1;
-				vertices[_vertBufferSize + 16] = tLeft.y - y - 1;
-
-				_texBufferSize += 12;
-				_vertBufferSize += 18;
-			}
-		}
-	}
-	
-	glBindBuffer(GL_ARRAY_BUFFER, vertexBufferID);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(float) * (_vertBufferSize + _texBufferSize),
-		0, GL_DYNAMIC_DRAW);
-
-	glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(float) * _vertBufferSize, &vertices[0]);
-	glBufferSubData(GL_ARRAY_BUFFER, sizeof(float) * _vertBufferSize, 
-								sizeof(float) * _texBufferSize, &textureCoords[0]);
-
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, (GLvoid*)(sizeof(float)*_vertBufferSize));
-
 	glEnableVertexAttribArray(0);
-	glEnableVertexAttribArray(1);
 
 }
 
-// Randomonly select a block/ reset position to the top of the grid.
-void newBlock(){
-	//random number between 0 and 7
-	uint8 _block = (rand() % 7);
-	currentBlockType = (0x1 << (_block));
-	currentBlockID = _block; 
+// Plays versus frames as they fall due, sending + receiving input every tick 
+void updateVersus(float tickMS){
+	versusPeer.poll(*versus);
 
-	//copys the block to the current block array 
-	for (uint8 _i = 0; _i < 16; _i++){
-		currentBlock[_i] = Block[_block][_i];
-	}
+	versusElapsed += tickMS;
+	while (versusElapsed >= versusFrameMS){
+		versusElapsed -= versusFrameMS;
 
-	// If start position obstructed clear grid 
-	if (grid[gridSize.x / 2]){
-		for (int _x = 1; _x < gridSize.x-1; _x++)
-			for (int _y = 0; _y < gridSize.y; _y++)
-				grid[(_y*gridSize.x) + _x] = 0;
-			
+		// Behind the peer's input or the peer is behind us, wait a frame 
+		if (!versus->canAdvance() || (versus->framesAhead() > 0 && (versus->getFrame() % 8) == 0)){
+			versus->synchronize();
+			continue;
+		}
+		versus->advance(versusInput | (softDrop ? VERSUS_SOFT_DROP : 0));
+		versusInput = 0;
 	}
 
-	blockPosition = Vec2(gridSize.x/2, 0);
+	versusPeer.send(*versus);
 }
 
-// Returns true if the current block is colliding with anything in grid.
-bool checkCollision(){
-
-	for (uint8 x = 0; x < 4; x++){
-		for (uint8 y = 0; y < 4; y++){
-			if (currentBlock[(y * 4) + x]){
-				uint8 _gridX = blockPosition.x - 1 + x; 
-				uint8 _gridY = blockPosition.y - 1 + y;
-
-				if (_gridX < 0 || _gridY < 0 || _gridX >= gridSize.x || _gridY >= gridSize.y){
-					return true; 
-				}
-
-				if (grid[(_gridY * gridSize.x) + _gridX]){
-					return true; 
-				}
-
-			}
-		}
+// Steps the game + every game on the wall 
+void update(float tickMS){
+	TRACE_SCOPE("update");
+	if (versus != NULL){
+		updateVersus(tickMS);
+		return;
 	}
 
-	return false; 
-
-
+	game.update(tickMS);
+	for (size_t _g = 0; _g < wallGames.size(); _g++)
+		wallGames[_g].update(tickMS);
 }
 
-// Rotates the current block. 
-void rotateBlock(){
-	//rather than doing anything too elobarate 
-	//square is not to rotate// line is speical case, everything else treated as a 3x3 matrix 
+// The game this machine plays, its side of the match while a versus match runs 
+const Game& localGame(){
+	return versus != NULL ? versus->getMatch().getGame(versus->getLocalPlayer()) : game;
+}
 
-	// Is square block 
-	if (currentBlockType & BLOCK_TYPE::BLOCK1){
-		return; 
+// Copies the state the renderer needs and makes it the latest snapshot 
+void publishSnapshot(){
+	const Game& _local = localGame();
+	GameSnapshot* _snapshot = snapshots.writeBuffer();
+	memcpy(_snapshot->grid, _local.getGrid(), sizeof(_snapshot->grid));
+	memcpy(_snapshot->currentBlock, _local.getCurrentBlock(), sizeof(_snapshot->currentBlock));
+	_snapshot->blockPosition = _local.getBlockPosition();
+	_snapshot->currentBlockID = _local.getCurrentBlockID();
+	_snapshot->tick = simulationThread.ticks();
+
+	// A versus match shows on the wall as its two boards 
+	int _boards = versus != NULL ? VersusMatch::players : (int)wallGames.size();
+	_snapshot->boardCount = _boards;
+	_snapshot->boards.resize(_boards * Game::cellCount);
+	for (int _g = 0; _g < _boards; _g++){
+		const Game& _game = versus != NULL ? versus->getMatch().getGame(_g) : wallGames[_g];
+		genBoardCells(&_snapshot->boards[_g * Game::cellCount], _game.getGrid(), gridSize, 
+					  _game.getCurrentBlock(), _game.getBlockPosition(), _game.getCurrentBlockID());
 	}
 
-	//Copy block to temp array 
-	uint8 temp[16];
-	for (uint8 i = 0; i < 16; i++)
-		temp[i] = currentBlock[i];
-
-	// Is line block 
-	if (currentBlockType & BLOCK_TYPE::BLOCK2){
-		// Hard coded solution is simpler 
-		if (currentBlock[4] != 0){
-			for (uint8 i = 0; i < 16; i++){
-					currentBlock[i] = 0;
-			}
-			currentBlock[1] = 1; 
-			currentBlock[5] = 1;
-			currentBlock[9] = 1;
-			currentBlock[13] = 1;
-		}
-		else{
-			for (uint8 i = 0; i < 16; i++){
-				currentBlock[i] = Block[1][i];
-			}
-		}
-	
-	}
-	else if (currentBlockType >= BLOCK_TYPE::BLOCK6){ // Z blocks
-		
-		uint8 i = 0;
+	snapshots.publish();
+}
 
-		if (temp[0] == 0 && temp[1] == 0){
-			for (i = 0; i < 3; i++){
-				for (uint8 p = 0; p < 3; p++)
-					currentBlock[(p * 4) + i] = temp[((2 - i) * 4) + p];
-			}
-		}
-		else{
-			for (i = 0; i < 3; i++){
-				for (uint8 p = 0; p < 3; p++)
-					currentBlock[(p * 4) + i] = temp[((i) * 4) + (2 - p)];
-			}
-		}
+// One fixed length tick of game logic, runs on the simulation thread 
+void simulate(float tickMS){
+	applyInput(tickMS);
+	{
+		PROFILE_SCOPE(CPU_UPDATE);
+		update(tickMS);
 	}
-	else{	//!< every other block.
+	publishSnapshot();
+	spectatorServer.publish(localGame());
+}
 
-		uint8 i = 0;
+// Draws the hud text over everything else in screen space 
+void drawHud(){
+	if (hud.vertexFloats() == 0)
+		return;
 
-		for (i = 0; i < 3; i++){
-			for (uint8 p = 0; p < 3; p++)
-				currentBlock[(p * 4) + i] = temp[((2-i) * 4) + p];
-		}
-	}
+	glm::mat4 _screen = glm::ortho(0.0f, (float)windowSize.x, (float)windowSize.y, 0.0f);
+	glUniformMatrix4fv(_wvpMat, 1, false, glm::value_ptr(_screen));
+	glUniform1i(_useColour, 1);
+	glUniform4f(_solidColour, 1, 1, 1, 1);
 
-	// If collision after rotating, reset previous position
-	if (checkCollision()){
-		for (uint8 i = 0; i < 16; i++)
-			currentBlock[i] = temp[i];
-	}
+	glBindBuffer(GL_ARRAY_BUFFER, hudBufferID);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(float) * hud.vertexFloats(), hud.vertexData(), GL_STREAM_DRAW);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
+	glDisableVertexAttribArray(1);
+	glDrawArrays(GL_TRIANGLES, 0, hud.vertexFloats() / 3);
 
+	glUniformMatrix4fv(_wvpMat, 1, false, glm::value_ptr(projMat * viewMat));
+	glUniform1i(_useColour, 0);
 }
 
-void moveLeft(){
+// Rolling GPU time per stage, returns where the next line of text goes 
+float buildGpuOverlay(float _y){
+	char _line[128];
+	float _scale = 3;
 
-	bool _isColliding = false; 
+	snprintf(_line, sizeof(_line), "GPU MS    AVG    MIN    MAX");
+	hud.print(10, _y, _scale, _line);
 
-	for (uint8 x = 0; x < 4; x++){
-		for (uint8 y = 0; y < 4; y++){
-			if (currentBlock[(y*4)+x]){
-				if (blockPosition.x-2+x < 0 || blockPosition.y-1+y < 0){
-					_isColliding = true; 
-					break; 
-				}
-
-				if (grid[((blockPosition.y - 1 + y)*gridSize.x) + blockPosition.x - 2 + x]){
-					_isColliding = true;
-					break;
-				}
-
-
-			}
-		}
-	}
-	if (!_isColliding){
-		blockPosition.x -= 1;
+	for (int _s = 0; _s < GPU_STAGE_COUNT; _s++){
+		_y += Hud::lineHeight(_scale);
+		StatsSummary _stats = gpuProfiler.summary((GPU_STAGE)_s);
+		snprintf(_line, sizeof(_line), "%-6s %6.3f %6.3f %6.3f", GpuProfiler::stageName((GPU_STAGE)_s), 
+			_stats.avg, _stats.min, _stats.max);
+		hud.print(10, _y, _scale, _line);
 	}
+	return _y + (2 * Hud::lineHeight(_scale));
 }
 
-void moveRight(){
-	bool _isColliding = false;
-
-	for (uint8 x = 0; x < 4; x++){
-		for (uint8 y = 0; y < 4; y++){
-			if (currentBlock[(y * 4) + x]){
-				if (blockPosition.x  + x >= gridSize.x || blockPosition.y - 1 + y > gridSize.y){
-					_isColliding = true;
-					break;
-				}
-
-				if (grid[((blockPosition.y - 1 + y)*gridSize.x) + blockPosition.x  + x]){
-					_isColliding = true;
-					break;
-				}
+#ifdef TETRIS_PROFILE
+// Rolling CPU time per stage in microseconds 
+float buildCpuHud(float _y){
+	char _line[128];
+	float _scale = 3;
 
+	hud.print(10, _y, _scale, "CPU US      MIN     AVG     MAX     P99");
 
-			}
-		}
-	}
-	if (!_isColliding){
-		blockPosition.x += 1;
+	for (int _s = 0; _s < CPU_STAGE_COUNT; _s++){
+		_y += Hud::lineHeight(_scale);
+		StatsSummary _stats = cpuProfiler.summary((CPU_STAGE)_s);
+		snprintf(_line, sizeof(_line), "%-6s %7.1f %7.1f %7.1f %7.1f", CpuProfiler::stageName((CPU_STAGE)_s),
+			_stats.min, _stats.avg, _stats.max, _stats.p99);
+		hud.print(10, _y, _scale, _line);
 	}
+	return _y + (2 * Hud::lineHeight(_scale));
 }
+#endif
 
-//Remove a line by a given y coordinate
-void removeLine(uint8 y){
+// Uploads and draws the single game 
+void drawBoard(const DrawList& list){
+	gpuProfiler.begin(GPU_UPLOAD);
+	glBindBuffer(GL_ARRAY_BUFFER, vertexBufferID);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(float) * (list.vertBufferSize + list.texBufferSize),
+		0, GL_DYNAMIC_DRAW);
 
-	// Remove the enteries in grid#
-	for (uint8 _x = 1; _x < gridSize.x - 1; _x++){
-		grid[(y * gridSize.x) + _x] = 0; 
-	}
+	glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(float) * list.vertBufferSize, &list.vertices[0]);
+	glBufferSubData(GL_ARRAY_BUFFER, sizeof(float) * list.vertBufferSize, 
+								sizeof(float) * list.texBufferSize, &list.textureCoords[0]);
+	gpuProfiler.end(GPU_UPLOAD);
 
-	// Move all blocks above down by 1 
-	for (uint8 _x = 1; _x < gridSize.x - 1; _x++){
-		for (uint8 _y = y; gridSize.y - _y != 0; _y--){		
-			// set to block above
-			grid[(y * gridSize.x) + _x] = grid[((y - 1) * gridSize.x) + _x];
-		}
-	}
-
-}
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
+	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, (GLvoid*)(sizeof(float)*list.vertBufferSize));
 
-void checkLineComplete(){
-	//Accounts for brick outline 
-	for (uint8 _y = 0; _y < gridSize.y; _y++){
-		bool lineComplete = true; 
-		for (uint8 _x = 1; _x < gridSize.x-1; _x++){
-			
-			if (grid[(_y * gridSize.x) + _x] > 0){
-				continue; 
-			}
-			else{
-				lineComplete = false; 
-				break; 
-			}
-		}
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(1);
 
-		if (lineComplete){
-			removeLine(_y);
-		}
+	gpuProfiler.begin(GPU_DRAW);
+	{
+		PROFILE_SCOPE(CPU_DRAW);
+		TRACE_SCOPE("draw");
+		glDrawArrays(GL_TRIANGLES, 0, list.vertBufferSize/3);
 	}
+	gpuProfiler.end(GPU_DRAW);
 }
 
-void dropDown(){
-	// Check whether the block is about to collide, Note block pivot ==  1,1 
-	// Which will cause a bit of confusion below I'm sure
-
-	//Cordonites for top left of shapes new position 
-	Vec2 topLeft = blockPosition;
-	topLeft.x -= 1; 
-	bool _collisionDetected = false;
-
-
-	for (uint8 x = 0; x < 4; x++){
-		for (uint8 y = 0; y < 4; y++){
-			if (topLeft.x + x < 0 ){
-				continue;
-			}
-			else if (topLeft.y + y >= gridSize.y){
-				//check within bounds... 
-				if (currentBlock[(4 * y) + x]){
-					// Hit bottom of grid
-					_collisionDetected = true;
-					break; 
-				}
-			}
-
+// Uploads and draws a frame built by the game, runs on the render thread 
+void render(const DrawList& list){
 
+#ifdef _DEBUG
+	glCheck();
+#endif
 
-			if (currentBlock[(4 * y) + x])
-				if (grid[((topLeft.y + y)*(gridSize.x)) + topLeft.x + x]){
-					// Collision 
-					_collisionDetected = true; 
-					break; 
-				}
+	glBindTexture(GL_TEXTURE_2D, blockTexture);
 
+	glUniform1i(_useColour, 0);
 
+	if (list.boardCount > 0){
+		// Board upload + draw are a single stage for the wall 
+		gpuProfiler.begin(GPU_DRAW);
+		{
+			PROFILE_SCOPE(CPU_DRAW);
+			TRACE_SCOPE("draw");
+			spectatorWall.draw(&list.boards[0], list.boardCount);
 		}
-	}
-
-	if (_collisionDetected){
-		// Assign values in grid, create new block, return 
-		for (uint8 x = 0; x < 4; x++)
-			for (uint8 y = 0; y < 4; y++){
-				if (currentBlock[(4 * y) + x] )
-					grid[((blockPosition.y - 1 + y)*(gridSize.x)) + blockPosition.x - 1 + x] = currentBlockID + 1;
-			}
-
-		//Checks if any lines are complete. 
-		checkLineComplete(); 
-		newBlock();
+		gpuProfiler.end(GPU_DRAW);
 	}
 	else{
-		blockPosition.y++;
-	}
-	
-}
-
-void update(){
-
-	//glCheck();
-
-	SDL_PumpEvents();
-	float _currentTimeElapsed = SDL_GetTicks();
-	blockDropedElapsed += (_currentTimeElapsed - previousTimeElapsed) ; 
-	previousTimeElapsed = _currentTimeElapsed; 
-	if (blockDropedElapsed > blockDropMS){
-		blockDropedElapsed = 0; 
-		dropDown(); 
+		drawBoard(list);
 	}
 
+	hud.clear();
+	float _hudY = 10;
+	if (showGpuOverlay)
+		_hudY = buildGpuOverlay(_hudY);
+#ifdef TETRIS_PROFILE
+	cpuProfiler.collect();
+	if (showCpuHud)
+		_hudY = buildCpuHud(_hudY);
+#endif
+	drawHud();
 }
 
-void render(){
-	SDL_GL_SwapWindow(window);
-	glClear(GL_COLOR_BUFFER_BIT);
-
-	glBindTexture(GL_TEXTURE_2D, blockTexture);
-
-	/*glUniform1i(_useColour, 1);
-	//!< Draw the grid 
-	glBindBuffer(GL_ARRAY_BUFFER, gridLinesID);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
-	glDrawArrays(GL_LINES, 0, gridLinesVertices.size()/3);*/
+// Builds the draw list for the latest game state and hands it to the render thread
+void submitFrame(){
+	bool _fresh = false;
+	const GameSnapshot* _snapshot = snapshots.read(&_fresh);
+
+	// Nothing changed since the last frame was built 
+	if (!_fresh)
+		return;
+
+	DrawList* _list = renderThread.beginFrame();
+	{
+		PROFILE_SCOPE(CPU_GEN_BLOCK_BUFFER);
+		TRACE_SCOPE("genBlockBuffer");
+		genBlockBuffer(*_list, _snapshot->grid, gridSize, _snapshot->currentBlock, 
+					   _snapshot->blockPosition, _snapshot->currentBlockID);
+	}
+	_list->frame = ++frameCount;
 
-	glUniform1i(_useColour, 0);
+	// Boards on the wall are already merged into cells by the simulation thread 
+	_list->boardCount = _snapshot->boardCount;
+	_list->boards.assign(_snapshot->boards.begin(), _snapshot->boards.end());
 
-	genBlockBuffer();
-	glDrawArrays(GL_TRIANGLES, 0, _vertBufferSize/3);
-	
+	renderThread.submitFrame();
 }
 
 // Loads texture and returns id
@@ -864,14 +658,232 @@ int loadTexture(const char* FilePath){
 
 }
 
+//!< Command line options 
+struct Options{
+	bool softwareRenderer = false;	//!< --renderer software, draw on the CPU with no window/ GL 
+	int frames = 600;				//!< --frames n, frames to draw in software mode 
+	const char* outPath = NULL;		//!< --out file.ppm, where to save the last software frame
+	const char* streamPath = NULL;	//!< --stream path, stream every software frame to a file/ pipe ("-" for stdout)
+	STREAM_FORMAT streamFormat = STREAM_Y4M;	//!< --format y4m|rgba
+	int fps = 60;					//!< --fps n, frame rate of the software renderer/ stream, up to simulationRate
+	const char* gpuCsvPath = NULL;	//!< --gpu-csv file.csv, per frame GPU stage timings
+	int wallBoards = 0;				//!< --wall n, spectator wall of n boards (up to 256)
+	bool realtime = false;			//!< --realtime, run the simulation thread and draw at fps in real time
+	uint64 seed = (uint64)time(NULL);	//!< --seed n, block sequence of the game, wall game n uses seed + n
+	bool bot = false;				//!< --bot, the computer plays the game
+	int spectatePort = 0;			//!< --spectate-port n, stream the game to spectators on 127.0.0.1:n
+	const char* spectateSocket = NULL;	//!< --spectate-socket path, stream the game on a Unix socket
+	int versusPort = 0;				//!< --versus-port n, play a versus match from UDP port n (both sides need the same --seed)
+	std::string versusHost = "127.0.0.1";	//!< --versus-peer host:port, the other side of the match
+	int versusPeerPort = 0;
+	int versusPlayer = 0;			//!< --versus-player 0|1, which side this is
+	int versusDelay = 2;			//!< --versus-delay n, frames of local input delay, up to RollbackSession::maxInputDelay
+	const char* tracePath = NULL;	//!< --trace file.json, write a Chrome trace on exit (TETRIS_TRACE builds, F4 writes one any time)
+};
+
+Options parseOptions(int argc, char** argv){
+	Options _options;
+	for (int _i = 1; _i < argc; _i++){
+		std::string _arg = argv[_i];
+		bool _hasValue = _i + 1 < argc;
+
+		if (_arg == "--renderer" && _hasValue){
+			_options.softwareRenderer = std::string(argv[++_i]) == "software";
+		}
+		else if (_arg == "--frames" && _hasValue){
+			_options.frames = atoi(argv[++_i]);
+		}
+		else if (_arg == "--out" && _hasValue){
+			_options.outPath = argv[++_i];
+		}
+		else if (_arg == "--stream" && _hasValue){
+			_options.streamPath = argv[++_i];
+		}
+		else if (_arg == "--format" && _hasValue){
+			_options.streamFormat = std::string(argv[++_i]) == "rgba" ? STREAM_RGBA : STREAM_Y4M;
+		}
+		else if (_arg == "--fps" && _hasValue){
+			// Every frame steps the game at least one tick 
+			_options.fps = std::min(std::max(1, atoi(argv[++_i])), (int)simulationRate);
+		}
+		else if (_arg == "--gpu-csv" && _hasValue){
+			_options.gpuCsvPath = argv[++_i];
+		}
+		else if (_arg == "--wall" && _hasValue){
+			_options.wallBoards = std::min(std::max(0, atoi(argv[++_i])), (int)SpectatorWall::maxBoards);
+		}
+		else if (_arg == "--seed" && _hasValue){
+			_options.seed = strtoull(argv[++_i], NULL, 10);
+		}
+		else if (_arg == "--bot"){
+			_options.bot = true;
+		}
+		else if (_arg == "--spectate-port" && _hasValue){
+			_options.spectatePort = atoi(argv[++_i]);
+		}
+		else if (_arg == "--spectate-socket" && _hasValue){
+			_options.spectateSocket = argv[++_i];
+		}
+		else if (_arg == "--versus-port" && _hasValue){
+			_options.versusPort = atoi(argv[++_i]);
+		}
+		else if (_arg == "--versus-peer" && _hasValue){
+			std::string _peer = argv[++_i];
+			size_t _colon = _peer.rfind(':');
+			_options.versusHost = _peer.substr(0, _colon);
+			_options.versusPeerPort = _colon != std::string::npos ? atoi(_peer.c_str() + _colon + 1) : 0;
+		}
+		else if (_arg == "--versus-player" && _hasValue){
+			_options.versusPlayer = atoi(argv[++_i]) != 0 ? 1 : 0;
+		}
+		else if (_arg == "--versus-delay" && _hasValue){
+			_options.versusDelay = std::max(0, atoi(argv[++_i]));
+			if (_options.versusDelay > (int)RollbackSession::maxInputDelay){
+				std::cout << "--versus-delay is at most " << RollbackSession::maxInputDelay << " frames" << std::endl;
+				_options.versusDelay = (int)RollbackSession::maxInputDelay;
+			}
+		}
+		else if (_arg == "--trace" && _hasValue){
+			_options.tracePath = argv[++_i];
+		}
+		else if (_arg == "--realtime"){
+			_options.realtime = true;
+		}
+		else{
+			std::cout << "Unknown option: " << _arg << std::endl;
+		}
+	}
+	return _options;
+}
+
+// Writes the trace asked for with --trace, once every thread that records has stopped 
+void writeTrace(const Options& options){
+	if (options.tracePath == NULL)
+		return;
+	int _events = TRACE_FLUSH(options.tracePath);
+	if (_events >= 0)
+		std::cerr << "Trace: " << _events << " events written to " << options.tracePath << std::endl;
+}
+
+// Plays the game with no window, drawing each frame into memory on the CPU. 
+// Reports go to stderr as stdout may be carrying the video stream.
+int runSoftware(const Options& options){
+	IMG_Init(IMG_INIT_PNG);
+
+	SoftwareRenderer _renderer;
+	if (!_renderer.loadAtlas("blocks.png"))
+		return 1;
+	_renderer.resize(gridSize);
+
+	FrameStreamer _streamer;
+	if (options.streamPath != NULL && 
+		!_streamer.start(options.streamPath, options.streamFormat, _renderer.width(), _renderer.height(), options.fps))
+		return 1;
+
+	game.reset(options.seed);
+	game.newBlock();
+	publishSnapshot();
+
+	// Real time runs the simulation thread as the windowed game does, otherwise the game is stepped 
+	// a frame worth of ticks between frames as fast as possible 
+	const int _ticksPerFrame = simulationRate / options.fps;
+	if (options.realtime)
+		simulationThread.start(simulationRate, simulate);
+
+	double _renderSeconds = 0;
+	Uint64 _frameStart = SDL_GetPerformanceCounter();
+	const Uint64 _frameTicks = SDL_GetPerformanceFrequency() / options.fps;
+
+	for (int _frame = 0; _frame < options.frames; _frame++){
+		Uint64 _start = SDL_GetPerformanceCounter();
+		if (options.realtime){
+			const GameSnapshot* _snapshot = snapshots.read();
+			TRACE_SCOPE("draw");
+			_renderer.render(_snapshot->grid, gridSize, _snapshot->currentBlock, 
+							 _snapshot->blockPosition, _snapshot->currentBlockID);
+		}
+		else{
+			for (int _t = 0; _t < _ticksPerFrame; _t++){
+				applyInput(1000.0f / simulationRate);
+				update(1000.0f / simulationRate);
+				spectatorServer.publish(game);
+			}
+			TRACE_SCOPE("draw");
+			_renderer.render(game.getGrid(), gridSize, game.getCurrentBlock(), game.getBlockPosition(), 
+							 game.getCurrentBlockID());
+		}
+		_renderSeconds += (double)(SDL_GetPerformanceCounter() - _start) / SDL_GetPerformanceFrequency();
+
+		// Conversion + writing happen on the streamer's thread, in real time a busy pool drops the frame
+		if (options.streamPath != NULL){
+			uint8* _target = _streamer.acquireFrame(!options.realtime);
+			if (_target != NULL){
+				memcpy(_target, _renderer.pixels(), _renderer.width() * _renderer.height() * 4);
+				_streamer.submitFrame();
+			}
+		}
+
+		if (options.realtime){
+			_frameStart += _frameTicks;
+			while (SDL_GetPerformanceCounter() < _frameStart)
+				SDL_Delay(1);
+		}
+	}
+
+	simulationThread.stop();
+	spectatorServer.stop();
+	_streamer.stop();
+
+	std::cerr << "Software renderer: " << options.frames << " frames " << _renderer.width() << "x" 
+		<< _renderer.height() << ", " << (_renderSeconds > 0 ? options.frames / _renderSeconds : 0) 
+		<< " fps" << std::endl;
+	if (options.streamPath != NULL){
+		std::cerr << "Stream: " << _streamer.framesWritten() << " frames written, " 
+			<< _streamer.framesDropped() << " dropped" << std::endl;
+	}
+
+	if (options.outPath != NULL && !_renderer.writePPM(options.outPath)){
+		std::cerr << "Unable to write " << options.outPath << std::endl;
+		return 1;
+	}
+
+	IMG_Quit();
+	return 0;
+}
+
 int main(int argc, char** argv){
 
+	TRACE_THREAD("main");
+
+	Options _options = parseOptions(argc, argv);
+#ifdef TETRIS_TRACE
+	if (_options.tracePath != NULL)
+		tracePath = _options.tracePath;
+#else
+	if (_options.tracePath != NULL)
+		std::cout << "Tracing is not built in, define TETRIS_TRACE" << std::endl;
+#endif
+	if (_options.bot)
+		bot = new Bot();
+	if ((_options.spectatePort > 0 || _options.spectateSocket != NULL) && 
+		!spectatorServer.start(_options.spectatePort, _options.spectateSocket))
+		std::cout << "Spectator server unavailable" << std::endl;
+	if (_options.softwareRenderer){
+		int _result = runSoftware(_options);
+		writeTrace(_options);
+		delete bot;
+		return _result;
+	}
+
 	//!<Initialise SDL 
 	if (SDL_Init(SDL_INIT_EVERYTHING) != 0){
 		return 1;
 	}
 
+	startupStageStart = SDL_GetPerformanceCounter(); 
+
 	IMG_Init(IMG_INIT_PNG);
+	startupStage("image init");
 
 	window = SDL_CreateWindow("Tetris", 100, 100, windowSize.x, windowSize.y, SDL_WINDOW_OPENGL);
 	
@@ -883,7 +895,10 @@ int main(int argc, char** argv){
 	//!< Create the OpenGl Context for this window 
 	glcontext = SDL_GL_CreateContext(window);
 
+	startupStage("window + context");
+
 	glewInit();
+	startupStage("glew");
 
 	//!<OpenGl init.. 
 	glClearColor(0, 0, 0, 1);
@@ -891,30 +906,77 @@ int main(int argc, char** argv){
 
 	gameRunning = true; 
 
+	wallBoards = _options.wallBoards;
+
+	if (_options.versusPort > 0){
+		if (versusPeer.open(_options.versusPort, _options.versusHost.c_str(), _options.versusPeerPort)){
+			versus = new RollbackSession(_options.seed, _options.versusPlayer, _options.versusDelay);
+			wallBoards = VersusMatch::players;
+		}
+		else{
+			std::cout << "Versus unavailable, playing alone" << std::endl;
+		}
+	}
+
 	//Init the game // set up viewport matrices etc.. 
 	init();
+	startupStage("init (textures, shaders, buffers)");
+
+	if (_options.gpuCsvPath != NULL && !gpuProfiler.openCsv(_options.gpuCsvPath))
+		std::cout << "Unable to open " << _options.gpuCsvPath << std::endl;
+	printStartupProfile();
 
 	// Create first block 
-	newBlock(); 
+	game.reset(_options.seed);
+	game.newBlock(); 
+
+	// The versus boards come from the match 
+	wallGames.resize(versus != NULL ? 0 : wallBoards);
+	for (size_t _b = 0; _b < wallGames.size(); _b++){
+		wallGames[_b].reset(_options.seed + _b + 1);
+		wallGames[_b].newBlock();
+	}
+	publishSnapshot(); 
 
-	while (gameRunning){
-		//!< Update the game 
-		update(); 
+	//!< Hand the context over to the render thread 
+	SDL_GL_MakeCurrent(window, NULL);
+	renderThread.start(window, glcontext, render, &gpuProfiler);
 
-		//!< Render the game 
-		render(); 
+	//!< Game logic from here on only runs on the simulation thread 
+	simulationThread.start(simulationRate, simulate);
 
+	while (gameRunning){
 		//!< Poll for input 
 		poll();
+
+		//!< Render the game, never blocks on the swap or the simulation 
+		submitFrame(); 
+
+		SDL_Delay(1);
 	}
 
+	simulationThread.stop();
+	spectatorServer.stop();
+	versusPeer.close();
+	delete versus;
+	delete bot;
+
+	// Takes the context back for clean up 
+	renderThread.stop();
+
 	//Clean up 
+	gpuProfiler.shutdown();
+	gpuProfiler.closeCsv();
+	if (wallBoards > 0)
+		spectatorWall.shutdown();
 	glDeleteTextures(1, &blockTexture);
 
 	//Destroy the OGL Context and window 
 	SDL_GL_DeleteContext(glcontext);
 	SDL_DestroyWindow(window);
 	
+	writeTrace(_options);
+
 	SDL_Quit(); 
 	return 0; 
 
@@ -0,0 +1,7 @@
+#include "Profiler.h"
+
+#ifdef TETRIS_PROFILE
+
+CpuProfiler cpuProfiler;
+
+#endif
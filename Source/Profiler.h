@@ -0,0 +1,79 @@
+/*Tetris
+Description: Lightweight CPU timers for each stage of a frame, shown on the hud with F3.
+
+			Only built when TETRIS_PROFILE is defined (debug builds), otherwise PROFILE_SCOPE
+			expands to nothing and none of this is compiled. Each stage is timed on a single thread,
+			samples are passed to the render thread through a lock free queue per stage.
+*/
+
+#pragma once
+
+#ifdef TETRIS_PROFILE
+
+#include <SDL2/SDL.h>
+
+#include "Common.h"
+#include "Exchange.h"
+#include "RollingStats.h"
+
+enum CPU_STAGE{
+	CPU_POLL,				//!< poll(), main thread 
+	CPU_UPDATE,				//!< update(), simulation thread 
+	CPU_GEN_BLOCK_BUFFER,	//!< genBlockBuffer(), main thread 
+	CPU_DRAW,				//!< Block draw call, render thread 
+	CPU_SWAP,				//!< SDL_GL_SwapWindow, render thread 
+	CPU_STAGE_COUNT
+};
+
+class CpuProfiler{
+public:
+	static const uint32 window = 240;	//!< Samples in the rolling report
+
+	//!< Any thread, but only ever the same one for a given stage
+	void record(CPU_STAGE stage, Uint64 ticks){
+		samples[stage].push((float)((double)ticks * 1000000.0 / SDL_GetPerformanceFrequency()));
+	}
+
+	//!< Render thread: moves queued samples into the rolling windows
+	void collect(){
+		float _us;
+		for (int _s = 0; _s < CPU_STAGE_COUNT; _s++){
+			while (samples[_s].pop(_us))
+				stats[_s].add(_us);
+		}
+	}
+
+	//!< Render thread: summary in microseconds
+	StatsSummary summary(CPU_STAGE stage) const { return stats[stage].summary(); }
+
+	static const char* stageName(CPU_STAGE stage){
+		static const char* _names[CPU_STAGE_COUNT] = { "poll", "update", "genbuf", "draw", "swap" };
+		return _names[stage];
+	}
+
+private:
+	SpscQueue<float, 1024> samples[CPU_STAGE_COUNT];	//!< Dropped when full (hud closed for a while etc.)
+	RollingStats<window> stats[CPU_STAGE_COUNT];
+};
+
+extern CpuProfiler cpuProfiler;
+
+//!< Times the enclosing scope
+class ScopedTimer{
+public:
+	ScopedTimer(CPU_STAGE _stage) : stage(_stage), start(SDL_GetPerformanceCounter()) {}
+	~ScopedTimer() { cpuProfiler.record(stage, SDL_GetPerformanceCounter() - start); }
+private:
+	CPU_STAGE stage;
+	Uint64 start;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(stage) ScopedTimer PROFILE_CONCAT(_scopedTimer, __LINE__)(stage)
+
+#else
+
+#define PROFILE_SCOPE(stage)
+
+#endif
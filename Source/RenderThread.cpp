@@ -0,0 +1,61 @@
+#include "RenderThread.h"
+
+#include <GL/glew.h>
+
+#include "Profiler.h"
+#include "Engine/Trace.h"
+
+void RenderThread::start(SDL_Window* _window, SDL_GLContext _context, DrawFunc _draw, GpuProfiler* _profiler){
+	window = _window;
+	context = _context;
+	draw = _draw;
+	profiler = _profiler;
+
+	running = true;
+	thread = std::thread(&RenderThread::run, this);
+}
+
+void RenderThread::stop(){
+	if (!thread.joinable())
+		return;
+
+	running = false;
+	thread.join();
+
+	SDL_GL_MakeCurrent(window, context);
+}
+
+void RenderThread::run(){
+	TRACE_THREAD("render");
+	SDL_GL_MakeCurrent(window, context);
+
+	while (running){
+		const DrawList* _list = lists.acquire();
+
+		// Nothing new from the game yet
+		if (_list == NULL){
+			SDL_Delay(1);
+			continue;
+		}
+
+		if (profiler != NULL)
+			profiler->beginFrame();
+
+		glClear(GL_COLOR_BUFFER_BIT);
+		draw(*_list);
+
+		if (profiler != NULL)
+			profiler->begin(GPU_SWAP);
+		{
+			PROFILE_SCOPE(CPU_SWAP);
+			TRACE_SCOPE("swap");
+			SDL_GL_SwapWindow(window);
+		}
+		if (profiler != NULL){
+			profiler->end(GPU_SWAP);
+			profiler->endFrame();
+		}
+	}
+
+	SDL_GL_MakeCurrent(window, NULL);
+}
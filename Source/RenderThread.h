@@ -0,0 +1,52 @@
+/*Tetris
+Description: Thread that owns the OpenGL context.
+
+			The render thread picks up the most recent DrawList submitted by the game, draws it
+			and swaps the window, so a blocking swap or a driver stall never holds up update()/ poll().
+			SDL events still have to be handled on the main thread, only GL work happens here.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <thread>
+
+#include <SDL2/SDL.h>
+
+#include "Common.h"
+#include "DrawList.h"
+#include "Exchange.h"
+#include "GpuProfiler.h"
+
+class RenderThread{
+public:
+	//!< Called on the render thread with the context current, should issue the draw calls for the list
+	typedef void (*DrawFunc)(const DrawList& list);
+
+	RenderThread() {}
+	~RenderThread() { stop(); }
+
+	//!< The context must not be current on the calling thread, ownership passes to the render thread.
+	//!< The profiler (optional) is driven from the render thread and times the swap.
+	void start(SDL_Window* window, SDL_GLContext context, DrawFunc draw, GpuProfiler* profiler = NULL);
+
+	//!< Joins the render thread and makes the context current on the calling thread again
+	void stop();
+
+	//!< Returns the list to build the next frame into, call submitFrame() when done
+	DrawList* beginFrame() { return lists.beginWrite(); }
+	void submitFrame() { lists.publish(); }
+
+private:
+	void run();
+
+	SDL_Window* window = NULL;
+	SDL_GLContext context = NULL;
+	DrawFunc draw = NULL;
+	GpuProfiler* profiler = NULL;
+
+	std::thread thread;
+	std::atomic<bool> running{ false };
+
+	DoubleBufferExchange<DrawList> lists;
+};
@@ -0,0 +1,55 @@
+/*Tetris
+Description: Fixed size window of the most recent samples with min/ avg/ max/ percentile summaries.
+*/
+
+#pragma once
+
+#include <algorithm>
+
+#include "Common.h"
+
+struct StatsSummary{
+	double min = 0;
+	double avg = 0;
+	double max = 0;
+	double p99 = 0;
+	uint32 count = 0;
+};
+
+template <uint32 Size>
+class RollingStats{
+public:
+	void add(double sample){
+		samples[next] = sample;
+		next = (next + 1) % Size;
+		if (count < Size)
+			count++;
+	}
+
+	//!< Summarises the current window, sorts a copy so keep it to once per displayed frame 
+	StatsSummary summary() const{
+		StatsSummary _summary;
+		_summary.count = count;
+		if (count == 0)
+			return _summary;
+
+		double _sorted[Size];
+		std::copy(samples, samples + count, _sorted);
+		std::sort(_sorted, _sorted + count);
+
+		double _total = 0;
+		for (uint32 _i = 0; _i < count; _i++)
+			_total += _sorted[_i];
+
+		_summary.min = _sorted[0];
+		_summary.max = _sorted[count - 1];
+		_summary.avg = _total / count;
+		_summary.p99 = _sorted[std::min(count - 1, (uint32)(count * 0.99))];
+		return _summary;
+	}
+
+private:
+	double samples[Size];
+	uint32 next = 0;
+	uint32 count = 0;
+};
@@ -0,0 +1,200 @@
+#include "ShaderCache.h"
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+
+#include <SDL2/SDL.h>
+
+namespace{
+
+	const uint32 cacheMagic = 0x53435454; // "TTCS"
+	const uint32 cacheVersion = 1;
+
+	//!< Header written in front of the program binary
+	struct CacheHeader{
+		uint32 magic;
+		uint32 version;
+		uint64 key;			//!< Driver strings + shader source hash
+		uint32 format;		//!< Binary format returned by glGetProgramBinary
+		uint32 length;		//!< Size of the binary following the header
+		double compileMS;	//!< How long the compile + link took when the cache was written
+	};
+
+	double elapsedMS(Uint64 start){
+		return (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+	}
+
+	const char* glString(GLenum name){
+		const GLubyte* _str = glGetString(name);
+		return _str ? (const char*)_str : "";
+	}
+
+	// Program binaries are core in 4.1, otherwise require the extension
+	bool binariesSupported(){
+		if (!GLEW_VERSION_4_1 && !GLEW_ARB_get_program_binary)
+			return false;
+
+		GLint _formats = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &_formats);
+		return _formats > 0;
+	}
+
+	// Compiles a single shader, prints the info log on failure
+	GLuint compileShader(GLenum type, const std::string& source, const char* name){
+		GLuint _shader = glCreateShader(type);
+		const char* _source = source.c_str();
+		glShaderSource(_shader, 1, &_source, NULL);
+		glCompileShader(_shader);
+
+		GLint _success = 0;
+		glGetShaderiv(_shader, GL_COMPILE_STATUS, &_success);
+		if (_success == GL_FALSE){
+			GLint _logSize = 0;
+			glGetShaderiv(_shader, GL_INFO_LOG_LENGTH, &_logSize);
+			std::vector<char> _log(_logSize > 0 ? _logSize : 1, 0);
+			glGetShaderInfoLog(_shader, (GLsizei)_log.size(), NULL, &_log[0]);
+			std::cout << name << " Shader Failed: " << &_log[0] << std::endl;
+			glDeleteShader(_shader);
+			return 0;
+		}
+		return _shader;
+	}
+
+	bool linkStatus(GLuint program, bool printLog){
+		GLint _success = 0;
+		glGetProgramiv(program, GL_LINK_STATUS, &_success);
+		if (_success == GL_FALSE && printLog){
+			GLint _logSize = 0;
+			glGetProgramiv(program, GL_INFO_LOG_LENGTH, &_logSize);
+			std::vector<char> _log(_logSize > 0 ? _logSize : 1, 0);
+			glGetProgramInfoLog(program, (GLsizei)_log.size(), NULL, &_log[0]);
+			std::cout << "Program Link Failed: " << &_log[0] << std::endl;
+		}
+		return _success != GL_FALSE;
+	}
+
+	// Attempts to create the program from the cache file, returns 0 on a miss or rejection
+	GLuint loadFromCache(const char* cachePath, uint64 key, double* compileMS){
+		std::ifstream _file(cachePath, std::ios::binary);
+		if (!_file)
+			return 0;
+
+		CacheHeader _header;
+		if (!_file.read((char*)&_header, sizeof(_header)))
+			return 0;
+		if (_header.magic != cacheMagic || _header.version != cacheVersion || _header.key != key)
+			return 0;
+
+		std::vector<char> _binary(_header.length);
+		if (_header.length == 0 || !_file.read(&_binary[0], _header.length))
+			return 0;
+
+		GLuint _program = glCreateProgram();
+		glProgramBinary(_program, _header.format, &_binary[0], _header.length);
+
+		// Driver updates etc. can invalidate the binary even when the strings match
+		if (!linkStatus(_program, false)){
+			glDeleteProgram(_program);
+			return 0;
+		}
+
+		*compileMS = _header.compileMS;
+		return _program;
+	}
+
+	void saveToCache(const char* cachePath, uint64 key, GLuint program, double compileMS){
+		GLint _length = 0;
+		glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &_length);
+		if (_length <= 0)
+			return;
+
+		std::vector<char> _binary(_length);
+		GLenum _format = 0;
+		glGetProgramBinary(program, _length, NULL, &_format, &_binary[0]);
+
+		CacheHeader _header;
+		_header.magic = cacheMagic;
+		_header.version = cacheVersion;
+		_header.key = key;
+		_header.format = _format;
+		_header.length = (uint32)_length;
+		_header.compileMS = compileMS;
+
+		std::ofstream _file(cachePath, std::ios::binary | std::ios::trunc);
+		if (!_file){
+			std::cout << "Unable to write shader cache: " << cachePath << std::endl;
+			return;
+		}
+		_file.write((const char*)&_header, sizeof(_header));
+		_file.write(&_binary[0], _length);
+	}
+
+}
+
+uint64 hashString(const std::string& str, uint64 hash){
+	for (size_t _i = 0; _i < str.size(); _i++){
+		hash ^= (uint8)str[_i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+GLuint loadCachedProgram(const char* cachePath, const std::string& vertexSource,
+						 const std::string& fragmentSource, ShaderCacheStats* stats){
+
+	Uint64 _start = SDL_GetPerformanceCounter();
+	ShaderCacheStats _stats;
+
+	bool _useCache = cachePath != NULL && binariesSupported();
+
+	uint64 _key = hashString(glString(GL_VENDOR));
+	_key = hashString(glString(GL_RENDERER), _key);
+	_key = hashString(glString(GL_VERSION), _key);
+	_key = hashString(vertexSource, _key);
+	_key = hashString(fragmentSource, _key);
+
+	GLuint _program = 0;
+	if (_useCache)
+		_program = loadFromCache(cachePath, _key, &_stats.compileMS);
+
+	if (_program != 0){
+		_stats.cacheHit = true;
+		_stats.loadMS = elapsedMS(_start);
+		_stats.savedMS = _stats.compileMS - _stats.loadMS;
+	}
+	else{
+		// Cache miss/ rejected, compile from source
+		GLuint _vShader = compileShader(GL_VERTEX_SHADER, vertexSource, "Vertex");
+		GLuint _fShader = compileShader(GL_FRAGMENT_SHADER, fragmentSource, "Frag");
+
+		if (_vShader != 0 && _fShader != 0){
+			_program = glCreateProgram();
+			if (_useCache)
+				glProgramParameteri(_program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+			glAttachShader(_program, _vShader);
+			glAttachShader(_program, _fShader);
+			glLinkProgram(_program);
+
+			if (!linkStatus(_program, true)){
+				glDeleteProgram(_program);
+				_program = 0;
+			}
+		}
+
+		// Shaders are no longer needed once linked (or failed)
+		glDeleteShader(_vShader);
+		glDeleteShader(_fShader);
+
+		_stats.compileMS = elapsedMS(_start);
+		_stats.loadMS = _stats.compileMS;
+
+		if (_program != 0 && _useCache)
+			saveToCache(cachePath, _key, _program, _stats.compileMS);
+	}
+
+	if (stats != NULL)
+		*stats = _stats;
+
+	return _program;
+}
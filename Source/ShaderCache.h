@@ -0,0 +1,33 @@
+/*Tetris
+Description: On-disk cache for linked shader program binaries.
+
+			Compiling and linking the shaders on every launch is the slowest part of start up
+			on some drivers, the linked program is saved with glGetProgramBinary and loaded back
+			with glProgramBinary on the next run. The cache is keyed by the vendor/ renderer/ version
+			strings and a hash of the shader source, any mismatch or a binary the driver rejects
+			falls back to compiling from source (and refreshes the cache).
+*/
+
+#pragma once
+
+#include <string>
+
+#include <GL/glew.h>
+
+#include "Common.h"
+
+//!< Timings reported back to the startup profile
+struct ShaderCacheStats{
+	bool cacheHit = false;		//!< Program was loaded from the cache
+	double loadMS = 0;			//!< Time spent creating the program this run
+	double compileMS = 0;		//!< Time a compile + link took (measured now, or when the cache was written)
+	double savedMS = 0;			//!< compileMS - loadMS on a cache hit
+};
+
+//!< 64 bit FNV-1a hash, used for the cache key
+uint64 hashString(const std::string& str, uint64 hash = 14695981039346656037ULL);
+
+//!< Returns a linked program, from the cache at cachePath when possible, otherwise compiled from source.
+//!< Returns 0 if the shaders fail to compile/ link, the reason is written to std::cout.
+GLuint loadCachedProgram(const char* cachePath, const std::string& vertexSource,
+						 const std::string& fragmentSource, ShaderCacheStats* stats = NULL);
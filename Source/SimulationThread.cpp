@@ -0,0 +1,57 @@
+#include "SimulationThread.h"
+
+#include <chrono>
+
+#include "Engine/Trace.h"
+
+namespace{
+	// Falling this far behind (e.g. after a debugger break) skips ahead rather than fast forwarding
+	const uint32 maxCatchUpTicks = 250;
+}
+
+void SimulationThread::start(uint32 ticksPerSecond, StepFunc _step){
+	rate = ticksPerSecond;
+	step = _step;
+
+	running = true;
+	thread = std::thread(&SimulationThread::run, this);
+}
+
+void SimulationThread::stop(){
+	if (!thread.joinable())
+		return;
+
+	running = false;
+	thread.join();
+}
+
+void SimulationThread::run(){
+	TRACE_THREAD("simulation");
+
+	typedef std::chrono::steady_clock Clock;
+
+	const Clock::duration _tick = std::chrono::duration_cast<Clock::duration>(std::chrono::seconds(1)) / rate;
+	const float _tickMS = 1000.0f / rate;
+
+	Clock::time_point _next = Clock::now();
+
+	while (running){
+		Clock::time_point _now = Clock::now();
+
+		if (_now < _next){
+			// Sleeping is only accurate to around a ms on most platforms, spin out the remainder 
+			if (_next - _now > std::chrono::milliseconds(2))
+				std::this_thread::sleep_for(_next - _now - std::chrono::milliseconds(1));
+			else
+				std::this_thread::yield();
+			continue;
+		}
+
+		if (_now - _next > _tick * maxCatchUpTicks)
+			_next = _now;
+
+		step(_tickMS);
+		tickCount.fetch_add(1, std::memory_order_relaxed);
+		_next += _tick;
+	}
+}
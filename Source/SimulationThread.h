@@ -0,0 +1,38 @@
+/*Tetris
+Description: Runs the game logic on its own thread at a fixed rate.
+
+			Each step advances the game by exactly 1000/rate ms so the logic no longer depends 
+			on how fast frames are drawn, the render side reads the results through a TripleBuffer.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <thread>
+
+#include "Common.h"
+
+class SimulationThread{
+public:
+	//!< Called once per tick on the simulation thread with the fixed tick length in ms
+	typedef void (*StepFunc)(float tickMS);
+
+	SimulationThread() {}
+	~SimulationThread() { stop(); }
+
+	void start(uint32 ticksPerSecond, StepFunc step);
+	void stop();
+
+	//!< Ticks simulated so far
+	uint64 ticks() const { return tickCount.load(std::memory_order_relaxed); }
+
+private:
+	void run();
+
+	uint32 rate = 1000;
+	StepFunc step = NULL;
+
+	std::thread thread;
+	std::atomic<bool> running{ false };
+	std::atomic<uint64> tickCount{ 0 };
+};
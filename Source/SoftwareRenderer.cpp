@@ -0,0 +1,180 @@
+#include "SoftwareRenderer.h"
+
+#include <cstring>
+#include <cstdio>
+#include <iostream>
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define TETRIS_BLIT_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TETRIS_BLIT_SSE2
+#endif
+
+namespace{
+
+	const int tileSize = SoftwareRenderer::tileSize;
+
+	// Opaque blue, RGBA in memory
+	const uint32 gridLineColour = 0xFFFF0000;
+
+	// Copies one 32 pixel (128 byte) row
+	inline void copyRow(uint32* dst, const uint32* src){
+#if defined(TETRIS_BLIT_AVX2)
+		for (int _i = 0; _i < tileSize; _i += 8)
+			_mm256_storeu_si256((__m256i*)(dst + _i), _mm256_loadu_si256((const __m256i*)(src + _i)));
+#elif defined(TETRIS_BLIT_SSE2)
+		for (int _i = 0; _i < tileSize; _i += 4)
+			_mm_storeu_si128((__m128i*)(dst + _i), _mm_loadu_si128((const __m128i*)(src + _i)));
+#else
+		memcpy(dst, src, tileSize * sizeof(uint32));
+#endif
+	}
+
+}
+
+bool SoftwareRenderer::loadAtlas(const char* filePath){
+	SDL_Surface* _image = IMG_Load(filePath);
+	if (_image == NULL){
+		std::cout << "Unable to load texture?: Error: " << SDL_GetError() << std::endl;
+		return false;
+	}
+
+	// ABGR8888 is R, G, B, A in memory on little endian
+	SDL_Surface* _rgba = SDL_ConvertSurfaceFormat(_image, SDL_PIXELFORMAT_ABGR8888, 0);
+	SDL_FreeSurface(_image);
+	if (_rgba == NULL){
+		std::cout << "Unable to convert texture: Error: " << SDL_GetError() << std::endl;
+		return false;
+	}
+
+	// Surface rows may be padded, repack them
+	std::vector<uint8> _pixels(_rgba->w * _rgba->h * 4);
+	SDL_LockSurface(_rgba);
+	for (int _y = 0; _y < _rgba->h; _y++)
+		memcpy(&_pixels[_y * _rgba->w * 4], (const uint8*)_rgba->pixels + (_y * _rgba->pitch), _rgba->w * 4);
+	SDL_UnlockSurface(_rgba);
+
+	setAtlas(&_pixels[0], _rgba->w, _rgba->h);
+	SDL_FreeSurface(_rgba);
+	return true;
+}
+
+void SoftwareRenderer::setAtlas(const uint8* rgba, int width, int height){
+	tileCount = width / tileSize;
+	tiles.assign(tileCount * tileSize * tileSize, 0);
+
+	const uint32* _src = (const uint32*)rgba;
+
+	// The GL path samples the top of a cell from the bottom row of the texture (v = 1 is the last
+	// row uploaded), store the rows flipped so both renderers produce the same picture
+	for (int _t = 0; _t < tileCount; _t++){
+		for (int _y = 0; _y < tileSize; _y++){
+			int _srcY = (tileSize - 1 - _y) < height ? (tileSize - 1 - _y) : height - 1;
+			memcpy(&tiles[(_t * tileSize + _y) * tileSize], &_src[(_srcY * width) + (_t * tileSize)],
+				tileSize * sizeof(uint32));
+		}
+	}
+}
+
+void SoftwareRenderer::resize(Vec2 gridSize){
+	if (frameWidth == gridSize.x * tileSize && frameHeight == gridSize.y * tileSize)
+		return;
+
+	frameWidth = gridSize.x * tileSize;
+	frameHeight = gridSize.y * tileSize;
+	frame.assign(frameWidth * frameHeight, 0xFF000000);
+
+	// Background with the grid lines the GL shader draws, along the top + left edge of each cell
+	emptyTile.assign(tileSize * tileSize, 0xFF000000);
+	for (int _i = 0; _i < tileSize; _i++){
+		emptyTile[_i] = gridLineColour;
+		emptyTile[_i * tileSize] = gridLineColour;
+	}
+}
+
+void SoftwareRenderer::blitTile(int cellX, int cellY, int tile){
+	if (tile < 0 || tile >= tileCount){
+		clearTile(cellX, cellY);
+		return;
+	}
+
+	const uint32* _src = &tiles[tile * tileSize * tileSize];
+	uint32* _dst = &frame[(cellY * tileSize * frameWidth) + (cellX * tileSize)];
+
+	for (int _y = 0; _y < tileSize; _y++){
+		copyRow(_dst, _src);
+		_src += tileSize;
+		_dst += frameWidth;
+	}
+}
+
+void SoftwareRenderer::clearTile(int cellX, int cellY){
+	const uint32* _src = &emptyTile[0];
+	uint32* _dst = &frame[(cellY * tileSize * frameWidth) + (cellX * tileSize)];
+
+	for (int _y = 0; _y < tileSize; _y++){
+		copyRow(_dst, _src);
+		_src += tileSize;
+		_dst += frameWidth;
+	}
+}
+
+void SoftwareRenderer::render(const uint8* grid, Vec2 gridSize, const uint8* currentBlock,
+							  Vec2 blockPosition, uint8 currentBlockID){
+	resize(gridSize);
+
+	// Every cell is written exactly once, either a tile or background
+	for (int _y = 0; _y < gridSize.y; _y++){
+		for (int _x = 0; _x < gridSize.x; _x++){
+			uint8 _cell = grid[(_y * gridSize.x) + _x];
+			if (_cell > 0)
+				blitTile(_x, _y, _cell - 1);
+			else
+				clearTile(_x, _y);
+		}
+	}
+
+	// Falling block on top
+	for (int p = 0; p < 4; p++){
+		for (int q = 0; q < 4; q++){
+			if (currentBlock[(q * 4) + p] == 1){
+				int _gridX = blockPosition.x - 1 + p;
+				int _gridY = blockPosition.y - 1 + q;
+
+				if (_gridX < 0 || _gridY < 0 || _gridX >= gridSize.x || _gridY >= gridSize.y)
+					continue;
+
+				blitTile(_gridX, _gridY, currentBlockID);
+			}
+		}
+	}
+}
+
+bool SoftwareRenderer::writePPM(const char* filePath) const{
+	FILE* _file = fopen(filePath, "wb");
+	if (_file == NULL)
+		return false;
+
+	fprintf(_file, "P6\n%d %d\n255\n", frameWidth, frameHeight);
+
+	std::vector<uint8> _row(frameWidth * 3);
+	const uint8* _src = pixels();
+	for (int _y = 0; _y < frameHeight; _y++){
+		for (int _x = 0; _x < frameWidth; _x++){
+			_row[(_x * 3) + 0] = _src[0];
+			_row[(_x * 3) + 1] = _src[1];
+			_row[(_x * 3) + 2] = _src[2];
+			_src += 4;
+		}
+		fwrite(&_row[0], 1, _row.size(), _file);
+	}
+
+	bool _ok = ferror(_file) == 0;
+	fclose(_file);
+	return _ok;
+}
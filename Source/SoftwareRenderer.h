@@ -0,0 +1,55 @@
+/*Tetris
+Description: CPU renderer, draws the board into an RGBA memory buffer without a GPU.
+
+			Used for thumbnails/ previews/ golden image tests on machines with no GL. Draws the
+			same cells as genBlockBuffer + render(), each cell is a straight 32x32 copy of its tile
+			from the blocks.png atlas so the image is gridSize * 32 pixels. Tiles are copied with
+			SSE2 (or AVX2 when compiled for it), a plain memcpy on other targets.
+*/
+
+#pragma once
+
+#include <vector>
+
+#include "Common.h"
+
+class SoftwareRenderer{
+public:
+	static const int tileSize = 32;
+
+	SoftwareRenderer() {}
+
+	//!< Loads the tile atlas (8 tiles across) with SDL_image, returns false on failure
+	bool loadAtlas(const char* filePath);
+
+	//!< Uses an already decoded RGBA atlas, width must be a multiple of tileSize
+	void setAtlas(const uint8* rgba, int width, int height);
+
+	//!< Sizes the output for a grid, only allocates when the size changes
+	void resize(Vec2 gridSize);
+
+	//!< Draws the grid + falling block, same inputs as genBlockBuffer
+	void render(const uint8* grid, Vec2 gridSize, const uint8* currentBlock,
+				Vec2 blockPosition, uint8 currentBlockID);
+
+	//!< RGBA output, 4 bytes per pixel, rows top to bottom
+	const uint8* pixels() const { return frame.empty() ? NULL : (const uint8*)&frame[0]; }
+	int width() const { return frameWidth; }
+	int height() const { return frameHeight; }
+
+	//!< Writes the last frame as a binary PPM, returns false on failure
+	bool writePPM(const char* filePath) const;
+
+private:
+	void blitTile(int cellX, int cellY, int tile);
+	void clearTile(int cellX, int cellY);
+
+	// Tiles are stored pre flipped and contiguous (32 rows of 32 pixels) so a blit reads linearly
+	std::vector<uint32> tiles;
+	int tileCount = 0;
+	std::vector<uint32> emptyTile;	//!< Background cell with grid lines
+
+	std::vector<uint32> frame;
+	int frameWidth = 0;
+	int frameHeight = 0;
+};
@@ -0,0 +1,336 @@
+#include "SpectatorServer.h"
+
+#include <cstring>
+
+#if defined(__linux__)
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+void SpectatorServer::publish(const Game& game){
+	if (!running.load(std::memory_order_relaxed))
+		return;
+
+	Vec2 _position = game.getBlockPosition();
+	if (published && _position.x == lastState.x && _position.y == lastState.y &&
+		game.getCurrentBlockID() == lastState.block && game.getBlocksPlaced() == lastState.blocks &&
+		game.getLinesCleared() == lastState.lines && game.getTopOuts() == lastState.topOuts){
+		// Rotating is the only change left, it keeps the pivot
+		uint32 _layout = 0;
+		const uint8* _block = game.getCurrentBlock();
+		for (int _i = 0; _i < 16; _i++)
+			_layout |= (_block[_i] != 0 ? 1u : 0u) << _i;
+		if (_layout == lastState.layout)
+			return;
+	}
+
+	// A state that does not fit is sent again on the next call, so the newest always gets through
+	boardState(game, lastState);
+	published = queue.push(lastState);
+	if (!published){
+		dropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+#if defined(__linux__)
+	// Pairs with the fence in run(), either the server sees the state or we see it asleep
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (sleeping.exchange(false)){
+		uint64 _one = 1;
+		ssize_t _written = write(wakeFd, &_one, sizeof(_one));
+		(void)_written;
+	}
+#endif
+}
+
+size_t SpectatorServer::opSize(uint64 offset) const{
+	return deltaOpSize(log[offset & (logSize - 1)]);
+}
+
+void SpectatorServer::append(const uint8* data, size_t size){
+	size_t _at = (size_t)(head & (logSize - 1));
+	size_t _first = size < logSize - _at ? size : logSize - _at;
+	memcpy(&log[_at], data, _first);
+	memcpy(&log[0], data + _first, size - _first);
+	head += size;
+}
+
+#if defined(__linux__)
+
+void SpectatorServer::add(const BoardState& state){
+	uint8 _ops[deltaMaxUpdate];
+	size_t _size = encoder.encode(state, _ops, !keyframed || head - lastKeyframe >= keyframeBytes);
+	if (_ops[0] == DELTA_KEYFRAME){
+		lastKeyframe = head;
+		keyframed = true;
+	}
+	append(_ops, _size);
+	encoded.fetch_add(1, std::memory_order_relaxed);
+	sequence.store(encoder.getSequence(), std::memory_order_relaxed);
+
+	// Clients can be removed while flushing, go backwards so none is missed
+	for (size_t _c = connections.size(); _c-- > 0;){
+		Connection* _client = connections[_c];
+		if (_client->kind != CONNECTION_CLIENT)
+			continue;
+		if (!_client->waiting)
+			flush(*_client);
+		else if (head - _client->cursor > logSize - deltaMaxUpdate)
+			close(_client);		// The log is about to overwrite what it has not been sent
+	}
+}
+
+bool SpectatorServer::start(int port, const char* _unixPath){
+	stop();
+
+	epoll = epoll_create1(EPOLL_CLOEXEC);
+	wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (epoll < 0 || wakeFd < 0){
+		stop();
+		return false;
+	}
+	wake = watch(wakeFd, CONNECTION_WAKE);
+
+	int _listening = 0;
+	if (port > 0){
+		int _fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+		int _reuse = 1;
+		setsockopt(_fd, SOL_SOCKET, SO_REUSEADDR, &_reuse, sizeof(_reuse));
+
+		sockaddr_in _address = {};
+		_address.sin_family = AF_INET;
+		_address.sin_port = htons((uint16)port);
+		_address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		if (_fd >= 0 && bind(_fd, (sockaddr*)&_address, sizeof(_address)) == 0 && listen(_fd, 64) == 0){
+			watch(_fd, CONNECTION_LISTEN);
+			_listening++;
+		}
+		else if (_fd >= 0){
+			::close(_fd);
+		}
+	}
+
+	if (_unixPath != NULL){
+		int _fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+		sockaddr_un _address = {};
+		_address.sun_family = AF_UNIX;
+		strncpy(_address.sun_path, _unixPath, sizeof(_address.sun_path) - 1);
+		unlink(_unixPath);
+		if (_fd >= 0 && bind(_fd, (sockaddr*)&_address, sizeof(_address)) == 0 && listen(_fd, 64) == 0){
+			watch(_fd, CONNECTION_LISTEN);
+			unixPath = _unixPath;
+			_listening++;
+		}
+		else if (_fd >= 0){
+			::close(_fd);
+		}
+	}
+
+	if (_listening == 0){
+		stop();
+		return false;
+	}
+
+	log.assign(logSize, 0);
+	head = 0;
+	keyframed = false;
+	encoder = DeltaEncoder();
+	sequence = 0;
+	published = false;
+	running = true;
+	thread = std::thread(&SpectatorServer::run, this);
+	return true;
+}
+
+void SpectatorServer::stop(){
+	if (thread.joinable()){
+		running = false;
+		uint64 _one = 1;
+		ssize_t _written = write(wakeFd, &_one, sizeof(_one));
+		(void)_written;
+		thread.join();
+	}
+
+	while (!connections.empty())
+		close(connections.back());
+	wake = NULL;
+	wakeFd = -1;
+	if (epoll >= 0)
+		::close(epoll);
+	epoll = -1;
+
+	if (unixPath != NULL)
+		unlink(unixPath);
+	unixPath = NULL;
+}
+
+SpectatorServer::Connection* SpectatorServer::watch(int fd, CONNECTION_KIND kind){
+	Connection* _connection = new Connection();
+	_connection->fd = fd;
+	_connection->kind = kind;
+	_connection->cursor = 0;
+	_connection->opEnd = 0;
+	_connection->waiting = false;
+
+	epoll_event _event = {};
+	_event.events = EPOLLIN;
+	_event.data.ptr = _connection;
+	epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &_event);
+	connections.push_back(_connection);
+	return _connection;
+}
+
+void SpectatorServer::close(Connection* connection){
+	epoll_ctl(epoll, EPOLL_CTL_DEL, connection->fd, NULL);
+	::close(connection->fd);
+	if (connection->kind == CONNECTION_CLIENT){
+		clients.fetch_sub(1, std::memory_order_relaxed);
+		if (running.load(std::memory_order_relaxed) && head - connection->cursor > logSize - deltaMaxUpdate)
+			kicked.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	for (size_t _c = 0; _c < connections.size(); _c++){
+		if (connections[_c] == connection){
+			connections[_c] = connections.back();
+			connections.pop_back();
+			break;
+		}
+	}
+	delete connection;
+}
+
+void SpectatorServer::accept(Connection& listener){
+	for (;;){
+		int _fd = accept4(listener.fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (_fd < 0)
+			return;
+
+		int _noDelay = 1;
+		setsockopt(_fd, IPPROTO_TCP, TCP_NODELAY, &_noDelay, sizeof(_noDelay));	// Fails harmlessly on Unix sockets
+
+		// Joins at the newest keyframe, everything after it is still in the log
+		Connection* _client = watch(_fd, CONNECTION_CLIENT);
+		_client->cursor = keyframed ? lastKeyframe : head;
+		_client->opEnd = _client->cursor;
+		clients.fetch_add(1, std::memory_order_relaxed);
+		flush(*_client);
+	}
+}
+
+void SpectatorServer::setWaiting(Connection& client, bool waiting){
+	if (client.waiting == waiting)
+		return;
+	client.waiting = waiting;
+
+	epoll_event _event = {};
+	_event.events = waiting ? EPOLLIN | EPOLLOUT : EPOLLIN;
+	_event.data.ptr = &client;
+	epoll_ctl(epoll, EPOLL_CTL_MOD, client.fd, &_event);
+}
+
+void SpectatorServer::flush(Connection& client){
+	while (client.cursor < head){
+		// Between ops, a client this far behind skips to the newest keyframe
+		bool _lagging = head - client.cursor > maxLag;
+		if (client.cursor == client.opEnd){
+			if (_lagging && lastKeyframe > client.cursor){
+				client.cursor = lastKeyframe;
+				skipped.fetch_add(1, std::memory_order_relaxed);
+				_lagging = false;
+			}
+			client.opEnd = client.cursor + opSize(client.cursor);
+		}
+
+		// A lagging client only finishes the op it is in before skipping
+		uint64 _end = _lagging ? client.opEnd : head;
+		size_t _at = (size_t)(client.cursor & (logSize - 1));
+		size_t _length = (size_t)(_end - client.cursor);
+		if (_length > logSize - _at)
+			_length = logSize - _at;
+
+		ssize_t _sent = send(client.fd, &log[_at], _length, MSG_NOSIGNAL | MSG_DONTWAIT);
+		if (_sent < 0){
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				setWaiting(client, true);
+			else if (errno != EINTR)
+				close(&client);
+			return;
+		}
+
+		client.cursor += (uint64)_sent;
+		sent.fetch_add((uint64)_sent, std::memory_order_relaxed);
+		while (client.opEnd < client.cursor)
+			client.opEnd += opSize(client.opEnd);
+	}
+	setWaiting(client, false);
+}
+
+void SpectatorServer::run(){
+	const int _maxEvents = 64;
+	epoll_event _events[_maxEvents];
+	BoardState _state;
+
+	while (running.load(std::memory_order_relaxed)){
+		while (queue.pop(_state))
+			add(_state);
+
+		// Pairs with the fence in publish(), a state pushed after the pop above wakes the loop
+		sleeping = true;
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (queue.pop(_state)){
+			sleeping = false;
+			add(_state);
+			continue;
+		}
+
+		int _count = epoll_wait(epoll, _events, _maxEvents, -1);
+		sleeping = false;
+
+		for (int _e = 0; _e < _count; _e++){
+			Connection* _connection = (Connection*)_events[_e].data.ptr;
+			if (_connection->kind == CONNECTION_WAKE){
+				uint64 _value;
+				ssize_t _read = read(wakeFd, &_value, sizeof(_value));
+				(void)_read;
+			}
+			else if (_connection->kind == CONNECTION_LISTEN){
+				accept(*_connection);
+			}
+			else if (_events[_e].events & (EPOLLERR | EPOLLHUP)){
+				close(_connection);
+			}
+			else{
+				if (_events[_e].events & EPOLLIN){
+					// Spectators have nothing to say, anything read is thrown away
+					uint8 _discard[256];
+					ssize_t _read = recv(_connection->fd, _discard, sizeof(_discard), MSG_DONTWAIT);
+					if (_read == 0 || (_read < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)){
+						close(_connection);
+						continue;
+					}
+				}
+				if (_events[_e].events & EPOLLOUT)
+					flush(*_connection);
+			}
+		}
+	}
+}
+
+#else
+
+bool SpectatorServer::start(int, const char*){
+	return false;
+}
+
+void SpectatorServer::stop(){
+}
+
+#endif
@@ -0,0 +1,113 @@
+/*Tetris
+Description: Streams a live game to any number of spectators over TCP and/ or Unix sockets.
+
+			The game loop only copies its state into a queue when a viewer could see a change (the
+			block moved or rotated, locked, cleared lines or a new one spawned), it never waits on
+			the network. Everything else happens on the server's thread, one epoll loop: each state
+			is delta encoded (DeltaCodec.h) once into a shared log. A client is only a position in
+			that log, every client is sent the same bytes straight from it, nothing is encoded or
+			copied per client.
+
+			A keyframe (the whole board) goes into the log at least every keyframeBytes. A client
+			that falls more than maxLag behind skips to the newest keyframe, so a slow reader only
+			ever sees fewer, newer updates. One whose socket stays full until the log wraps past it
+			is dropped.
+
+			The stream on the wire is the codec's ops back to back, a DeltaDecoder on the client
+			side applies them.
+
+			Linux only (epoll), start() returns false elsewhere.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "Common.h"
+#include "Exchange.h"
+#include "Engine/DeltaCodec.h"
+#include "Engine/Game.h"
+
+class SpectatorServer{
+public:
+	static const uint32 queueSize = 256;			//!< States waiting for the server thread
+	static const size_t logSize = 1 << 22;			//!< Shared log of encoded ops
+	static const size_t maxLag = 1 << 18;			//!< Clients further behind skip to the newest keyframe
+	static const size_t keyframeBytes = 1 << 16;	//!< Most log written between keyframes
+
+	SpectatorServer() {}
+	~SpectatorServer() { stop(); }
+
+	//!< Listens on 127.0.0.1:port (0 for no TCP) and/ or unixPath (NULL for none). Returns false
+	//!< if it could not listen on either.
+	bool start(int port, const char* unixPath);
+	void stop();
+
+	//!< Game thread: queues game's state when a spectator could see a change, never blocks
+	void publish(const Game& game);
+
+	uint32 clientCount() const { return clients.load(std::memory_order_relaxed); }
+	uint64 statesEncoded() const { return encoded.load(std::memory_order_relaxed); }
+	uint32 lastSequence() const { return sequence.load(std::memory_order_relaxed); }		//!< Of the newest op in the log
+	uint64 bytesSent() const { return sent.load(std::memory_order_relaxed); }
+	uint64 statesDropped() const { return dropped.load(std::memory_order_relaxed); }		//!< Queue was full
+	uint64 clientsSkipped() const { return skipped.load(std::memory_order_relaxed); }		//!< Jumps to a keyframe
+	uint64 clientsDropped() const { return kicked.load(std::memory_order_relaxed); }		//!< Disconnected for being too slow
+
+private:
+	enum CONNECTION_KIND{ CONNECTION_LISTEN, CONNECTION_WAKE, CONNECTION_CLIENT };
+
+	struct Connection{
+		int fd;
+		CONNECTION_KIND kind;
+		uint64 cursor;			//!< Client: next log byte to send
+		uint64 opEnd;			//!< Client: end of the op cursor is in, == cursor between ops
+		bool waiting;			//!< Client: socket full, waiting for EPOLLOUT
+	};
+
+	void run();
+
+	// Encodes state into the log then sends it on to every client
+	void add(const BoardState& state);
+	void append(const uint8* data, size_t size);
+
+	Connection* watch(int fd, CONNECTION_KIND kind);
+	void accept(Connection& listener);
+	void flush(Connection& client);
+	void close(Connection* connection);
+	void setWaiting(Connection& client, bool waiting);
+
+	// Size of the op starting at log offset
+	size_t opSize(uint64 offset) const;
+
+	// Game thread only
+	BoardState lastState = {};
+	bool published = false;
+
+	// Server thread only
+	std::vector<uint8> log;
+	uint64 head = 0;				//!< Log bytes written so far
+	uint64 lastKeyframe = 0;
+	bool keyframed = false;
+	DeltaEncoder encoder;
+	std::vector<Connection*> connections;
+	Connection* wake = NULL;
+	int epoll = -1;
+	int wakeFd = -1;				//!< eventfd the game thread writes when the server is asleep
+	const char* unixPath = NULL;
+
+	SpscQueue<BoardState, queueSize> queue;
+	std::atomic<bool> sleeping{ false };
+	std::atomic<bool> running{ false };
+	std::thread thread;
+
+	std::atomic<uint32> clients{ 0 };
+	std::atomic<uint64> encoded{ 0 };
+	std::atomic<uint32> sequence{ 0 };
+	std::atomic<uint64> sent{ 0 };
+	std::atomic<uint64> dropped{ 0 };
+	std::atomic<uint64> skipped{ 0 };
+	std::atomic<uint64> kicked{ 0 };
+};
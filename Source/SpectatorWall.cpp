@@ -0,0 +1,147 @@
+#include "SpectatorWall.h"
+
+#include <algorithm>
+#include <string>
+
+#include "ShaderCache.h"
+
+namespace{
+
+	// Gap between boards, in cells
+	const float boardGap = 1.0f;
+
+	const std::string vertexShader =
+		"#version 330 core \n "
+		"uniform usampler2D boards;"
+		"uniform int gridWidth;"
+		"uniform int cellsPerBoard;"
+		"uniform int columns;"
+		"uniform vec2 origin;"			// Top left of the first board, clip space
+		"uniform vec2 cellSize;"		// Clip space size of a cell
+		"uniform vec2 boardStride;"		// Clip space offset between neighbouring boards
+		"out vec2 texCoord;"
+		"const vec2 corners[6] = vec2[6](vec2(0,0), vec2(1,0), vec2(1,1), vec2(0,0), vec2(1,1), vec2(0,1));"
+		"void main(){"
+		"	int cellIndex = gl_VertexID / 6;"
+		"	int board = cellIndex / cellsPerBoard;"
+		"	int cell = cellIndex - (board * cellsPerBoard);"
+		"	uint value = texelFetch(boards, ivec2(cell, board), 0).r;"
+		"	if (value == 0u){ gl_Position = vec4(2.0, 2.0, 2.0, 1.0); texCoord = vec2(0.0); return; }"
+		"	vec2 corner = corners[gl_VertexID - (cellIndex * 6)];"
+		"	vec2 cellPos = vec2(cell % gridWidth, cell / gridWidth) + corner;"
+		"	vec2 boardPos = vec2(board % columns, board / columns);"
+		"	vec2 pos = origin + (boardPos * boardStride) + (cellPos * vec2(cellSize.x, -cellSize.y));"
+		"	gl_Position = vec4(pos, 0.0, 1.0);"
+		"	texCoord = vec2((float(value - 1u) + corner.x) / 8.0, 1.0 - corner.y);"
+		"}";
+
+	const std::string fragmentShader =
+		"#version 330 core  \n "
+		"uniform sampler2D tex;"
+		"in vec2 texCoord;"
+		"layout (location = 0) out vec4 colour;"
+		"void main(){"
+		"	colour = texture(tex, texCoord);"
+		"}";
+
+}
+
+bool SpectatorWall::init(GLuint atlasTexture, Vec2 _gridSize, Vec2 _windowSize){
+	atlas = atlasTexture;
+	gridSize = _gridSize;
+	windowSize = _windowSize;
+
+	program = loadCachedProgram("shader_wall.cache", vertexShader, fragmentShader);
+	if (program == 0)
+		return false;
+
+	glUseProgram(program);
+	glUniform1i(glGetUniformLocation(program, "tex"), 0);
+	glUniform1i(glGetUniformLocation(program, "boards"), 1);
+	glUniform1i(glGetUniformLocation(program, "gridWidth"), gridSize.x);
+	glUniform1i(glGetUniformLocation(program, "cellsPerBoard"), gridSize.x * gridSize.y);
+	_columns = glGetUniformLocation(program, "columns");
+	_origin = glGetUniformLocation(program, "origin");
+	_cellSize = glGetUniformLocation(program, "cellSize");
+	_boardStride = glGetUniformLocation(program, "boardStride");
+
+	// One row per board, one texel per cell
+	glGenTextures(1, &boardTexture);
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, boardTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R8UI, gridSize.x * gridSize.y, maxBoards, 0, 
+				 GL_RED_INTEGER, GL_UNSIGNED_BYTE, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glActiveTexture(GL_TEXTURE0);
+
+	return true;
+}
+
+void SpectatorWall::shutdown(){
+	glDeleteTextures(1, &boardTexture);
+	glDeleteProgram(program);
+	boardTexture = 0;
+	program = 0;
+}
+
+void SpectatorWall::layout(int count){
+	if (count == layoutCount)
+		return;
+	layoutCount = count;
+
+	float _boardW = gridSize.x + boardGap;
+	float _boardH = gridSize.y + boardGap;
+
+	// Largest cell (in pixels) over every column count
+	int _bestColumns = 1;
+	float _bestCell = 0;
+	for (int _c = 1; _c <= count; _c++){
+		int _rows = (count + _c - 1) / _c;
+		float _cell = std::min(windowSize.x / (_c * _boardW), windowSize.y / (_rows * _boardH));
+		if (_cell > _bestCell){
+			_bestCell = _cell;
+			_bestColumns = _c;
+		}
+	}
+
+	int _rows = (count + _bestColumns - 1) / _bestColumns;
+
+	// Pixels to clip space, centred in the window
+	float _cellX = 2.0f * _bestCell / windowSize.x;
+	float _cellY = 2.0f * _bestCell / windowSize.y;
+	float _usedX = (_bestColumns * _boardW - boardGap) * _cellX;
+	float _usedY = (_rows * _boardH - boardGap) * _cellY;
+
+	glUniform1i(_columns, _bestColumns);
+	glUniform2f(_cellSize, _cellX, _cellY);
+	glUniform2f(_boardStride, _boardW * _cellX, -_boardH * _cellY);
+	glUniform2f(_origin, -_usedX / 2, _usedY / 2);
+}
+
+void SpectatorWall::draw(const uint8* boards, int boardCount){
+	if (program == 0 || boardCount <= 0)
+		return;
+	if (boardCount > maxBoards)
+		boardCount = maxBoards;
+
+	GLint _previousProgram = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &_previousProgram);
+	glUseProgram(program);
+	layout(boardCount);
+
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, boardTexture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, gridSize.x * gridSize.y, boardCount, 
+					GL_RED_INTEGER, GL_UNSIGNED_BYTE, boards);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, atlas);
+
+	// No vertex attributes, everything comes from gl_VertexID
+	glDisableVertexAttribArray(0);
+	glDisableVertexAttribArray(1);
+	glDrawArrays(GL_TRIANGLES, 0, boardCount * gridSize.x * gridSize.y * 6);
+
+	glUseProgram(_previousProgram);
+}
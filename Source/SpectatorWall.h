@@ -0,0 +1,43 @@
+/*Tetris
+Description: Draws many boards at once for the tournament hall display.
+
+			The cells of every board are uploaded as one row each of an integer texture, then a
+			single glDrawArrays draws 6 vertices for every cell of every board. The vertex shader
+			works out which board/ cell a vertex belongs to from gl_VertexID and places it, empty
+			cells collapse to a point outside the view so no per board work happens on the CPU.
+*/
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include "Common.h"
+
+class SpectatorWall{
+public:
+	static const int maxBoards = 256;
+
+	//!< Creates the program + board texture, needs a current context. Returns false if the shaders fail.
+	bool init(GLuint atlasTexture, Vec2 gridSize, Vec2 windowSize);
+	void shutdown();
+
+	//!< Uploads the cells of boardCount boards (gridSize cells each, see genBoardCells) and draws them
+	void draw(const uint8* boards, int boardCount);
+
+private:
+	// Picks the columns that give the largest cells for count boards and sets the layout uniforms
+	void layout(int count);
+
+	GLuint program = 0;
+	GLuint boardTexture = 0;
+	GLuint atlas = 0;
+
+	GLint _columns = -1;
+	GLint _origin = -1;
+	GLint _cellSize = -1;
+	GLint _boardStride = -1;
+
+	Vec2 gridSize = Vec2(0, 0);
+	Vec2 windowSize = Vec2(0, 0);
+	int layoutCount = 0;
+};
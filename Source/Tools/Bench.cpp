@@ -0,0 +1,363 @@
+/*Tetris
+Description: Micro benchmarks for the engine hot paths, prints the results as JSON.
+
+			Every benchmark runs over a corpus of boards taken from seeded games, played by
+			placing each block at a random column/ rotation so the stacks have the holes and
+			overhangs of a real game. Results are nanoseconds per call + calls per second so
+			they can be compared release to release.
+
+			Needs the Engine library + DrawList.cpp only (no SDL/ GL), on Linux:
+				g++ -O2 -std=c++14 -ISource Source/Tools/Bench.cpp Source/Engine/Game.cpp Source/Engine/MoveGen.cpp \
+					Source/Engine/DeltaCodec.cpp Source/DrawList.cpp -o bench
+
+			Options:
+				--boards n		Boards in the corpus (default 256)
+				--seed n		Seed for the corpus (default 1)
+				--min-ms n		Minimum run time per benchmark (default 200)
+				--filter name	Only runs benchmarks whose name contains name
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "../Engine/DeltaCodec.h"
+#include "../Engine/Game.h"
+#include "../Engine/MoveGen.h"
+#include "../DrawList.h"
+
+namespace{
+
+	struct Result{
+		const char* name;
+		uint64 operations;
+		double seconds;
+	};
+
+	// Stops the compiler throwing away work whose result is never used
+	volatile uint64 sink = 0;
+
+	uint64 nextRandom(uint64& state){
+		state ^= state >> 12;
+		state ^= state << 25;
+		state ^= state >> 27;
+		return state * 0x2545F4914F6CDD1DULL;
+	}
+
+	// Places the falling block at a random rotation + column then drops it until it locks
+	void playRandomBlock(Game& game, uint64& random){
+		int _rotations = (int)(nextRandom(random) % 4);
+		for (int _r = 0; _r < _rotations; _r++)
+			game.rotateBlock();
+
+		int _shift = (int)(nextRandom(random) % 11) - 5;
+		for (int _s = 0; _s < _shift; _s++)
+			game.moveRight();
+		for (int _s = 0; _s > _shift; _s--)
+			game.moveLeft();
+
+		while (!game.dropDown()) {}
+	}
+
+	// Games stopped at random points, each with a freshly spawned block
+	std::vector<Game> buildCorpus(int boards, uint64 seed){
+		std::vector<Game> _corpus;
+		uint64 _random = seed * 0x9E3779B97F4A7C15ULL + 1;
+
+		while ((int)_corpus.size() < boards){
+			Game _game(seed + _corpus.size());
+			_game.setEndless(false);
+			_game.newBlock();
+
+			int _blocks = 5 + (int)(nextRandom(_random) % 40);
+			for (int _b = 0; _b < _blocks && !_game.isGameOver(); _b++)
+				playRandomBlock(_game, _random);
+
+			if (!_game.isGameOver())
+				_corpus.push_back(_game);
+		}
+		return _corpus;
+	}
+
+	// Fills the gaps in the bottom 1 - 4 rows so they are complete
+	Game withCompleteLines(const Game& game, int lines){
+		uint8 _grid[Game::cellCount];
+		memcpy(_grid, game.getGrid(), sizeof(_grid));
+		for (int _y = Game::height - lines; _y < Game::height; _y++){
+			for (int _x = 1; _x < Game::width - 1; _x++){
+				if (_grid[(_y * Game::width) + _x] == 0)
+					_grid[(_y * Game::width) + _x] = 1;
+			}
+		}
+		Game _game = game;
+		_game.setGrid(_grid);
+		return _game;
+	}
+
+	// Every state a spectator would see while game plays blocks random blocks one input at a time
+	std::vector<BoardState> buildStream(Game game, int blocks, uint64& random){
+		std::vector<BoardState> _stream;
+		BoardState _state;
+		boardState(game, _state);
+		_stream.push_back(_state);
+
+		uint32 _target = game.getBlocksPlaced() + blocks;
+		while (game.getBlocksPlaced() < _target && !game.isGameOver()){
+			switch (nextRandom(random) % 4){
+			case 0: game.rotateBlock(); break;
+			case 1: game.moveLeft(); break;
+			case 2: game.moveRight(); break;
+			default: game.dropDown(); break;
+			}
+			boardState(game, _state);
+			if (!(_state == _stream.back()))
+				_stream.push_back(_state);
+		}
+		return _stream;
+	}
+
+	// Calls run(corpus index) in batches until minMS has passed, each call does opsPerCall operations
+	template <typename Func>
+	Result measure(const char* name, size_t corpusSize, double minMS, uint64 opsPerCall, Func run){
+		typedef std::chrono::steady_clock Clock;
+
+		// Warm up the caches + branch predictors
+		for (size_t _i = 0; _i < corpusSize; _i++)
+			run(_i);
+
+		uint64 _calls = 0;
+		Clock::time_point _start = Clock::now();
+		double _elapsed = 0;
+		do{
+			for (size_t _i = 0; _i < corpusSize; _i++)
+				run(_i);
+			_calls += corpusSize;
+			_elapsed = std::chrono::duration<double>(Clock::now() - _start).count();
+		} while (_elapsed * 1000.0 < minMS);
+
+		Result _result = { name, _calls * opsPerCall, _elapsed };
+		return _result;
+	}
+
+	bool selected(const char* filter, const char* name){
+		return filter == NULL || strstr(name, filter) != NULL;
+	}
+
+}
+
+int main(int argc, char** argv){
+	int _boards = 256;
+	uint64 _seed = 1;
+	double _minMS = 200;
+	const char* _filter = NULL;
+
+	for (int _i = 1; _i < argc; _i++){
+		std::string _arg = argv[_i];
+		bool _hasValue = _i + 1 < argc;
+
+		if (_arg == "--boards" && _hasValue)
+			_boards = std::max(1, atoi(argv[++_i]));
+		else if (_arg == "--seed" && _hasValue)
+			_seed = strtoull(argv[++_i], NULL, 10);
+		else if (_arg == "--min-ms" && _hasValue)
+			_minMS = atof(argv[++_i]);
+		else if (_arg == "--filter" && _hasValue)
+			_filter = argv[++_i];
+		else{
+			fprintf(stderr, "Unknown option: %s\n", _arg.c_str());
+			return 1;
+		}
+	}
+
+	const std::vector<Game> _corpus = buildCorpus(_boards, _seed);
+	const size_t _count = _corpus.size();
+	Vec2 _gridSize(Game::width, Game::height);
+
+	std::vector<Game> _lineCorpus;
+	for (size_t _i = 0; _i < _count; _i++)
+		_lineCorpus.push_back(withCompleteLines(_corpus[_i], 1 + (int)(_i % 4)));
+
+	// Scratch copies so the corpus itself is never modified
+	std::vector<Game> _work(_corpus);
+	DrawList _list;
+
+	std::vector<Result> _results;
+
+	if (selected(_filter, "checkCollision")){
+		// Every column of the top 8 rows, collides + clear cases both covered
+		_results.push_back(measure("checkCollision", _count, _minMS, 88, [&](size_t i){
+			const Game& _game = _corpus[i];
+			uint64 _hits = 0;
+			for (int _y = 0; _y < 8; _y++){
+				for (int _x = 0; _x < 11; _x++)
+					_hits += _game.checkCollision(_game.getCurrentBlock(), Vec2(_x, _y));
+			}
+			sink += _hits;
+		}));
+	}
+
+	if (selected(_filter, "moveLeft")){
+		_results.push_back(measure("moveLeft", _count, _minMS, 8, [&](size_t i){
+			Game& _game = _work[i];
+			_game = _corpus[i];
+			for (int _m = 0; _m < 8; _m++)
+				sink += _game.moveLeft();
+		}));
+	}
+
+	if (selected(_filter, "moveRight")){
+		_results.push_back(measure("moveRight", _count, _minMS, 8, [&](size_t i){
+			Game& _game = _work[i];
+			_game = _corpus[i];
+			for (int _m = 0; _m < 8; _m++)
+				sink += _game.moveRight();
+		}));
+	}
+
+	if (selected(_filter, "rotateBlock")){
+		_results.push_back(measure("rotateBlock", _count, _minMS, 8, [&](size_t i){
+			Game& _game = _work[i];
+			_game = _corpus[i];
+			_game.dropDown(); // Clear of the top so rotations can succeed
+			for (int _m = 0; _m < 8; _m++)
+				sink += _game.rotateBlock();
+		}));
+	}
+
+	if (selected(_filter, "dropDown")){
+		// Counts every dropDown call, the last of each run locks, clears lines + spawns
+		uint64 _drops = 0;
+		for (size_t _i = 0; _i < _count; _i++){
+			Game _game = _corpus[_i];
+			do { _drops++; } while (!_game.dropDown());
+		}
+		_results.push_back(measure("dropDown", _count, _minMS, 1, [&](size_t i){
+			Game& _game = _work[i];
+			_game = _corpus[i];
+			while (!_game.dropDown()) {}
+			sink += _game.getBlocksPlaced();
+		}));
+		// measure() counted runs, convert to individual calls
+		_results.back().operations = (_results.back().operations / _count) * _drops;
+	}
+
+	if (selected(_filter, "checkLineComplete")){
+		_results.push_back(measure("checkLineComplete", _count, _minMS, 1, [&](size_t i){
+			Game& _game = _work[i];
+			_game = _corpus[i];
+			sink += _game.checkLineComplete();
+		}));
+		_results.push_back(measure("checkLineComplete+removeLine", _count, _minMS, 1, [&](size_t i){
+			Game& _game = _work[i];
+			_game = _lineCorpus[i];
+			sink += _game.checkLineComplete();
+		}));
+	}
+
+	if (selected(_filter, "removeLine")){
+		_results.push_back(measure("removeLine", _count, _minMS, 4, [&](size_t i){
+			Game& _game = _work[i];
+			_game = _corpus[i];
+			for (int _l = 0; _l < 4; _l++)
+				_game.removeLine(Game::height - 1 - _l);
+			sink += _game.getGrid()[Game::cellCount - 2];
+		}));
+	}
+
+	if (selected(_filter, "newBlock")){
+		_results.push_back(measure("newBlock", _count, _minMS, 8, [&](size_t i){
+			Game& _game = _work[i];
+			for (int _n = 0; _n < 8; _n++)
+				_game.newBlock();
+			sink += _game.getCurrentBlockID();
+		}));
+	}
+
+	if (selected(_filter, "genBlockBuffer")){
+		_results.push_back(measure("genBlockBuffer", _count, _minMS, 1, [&](size_t i){
+			const Game& _game = _corpus[i];
+			genBlockBuffer(_list, _game.getGrid(), _gridSize, _game.getCurrentBlock(),
+						   _game.getBlockPosition(), _game.getCurrentBlockID());
+			sink += _list.vertBufferSize;
+		}));
+	}
+
+	if (selected(_filter, "moveGen")){
+		MoveGen _moveGen;
+		_results.push_back(measure("moveGen", _count, _minMS, 1, [&](size_t i){
+			sink += _moveGen.generate(_corpus[i]);
+		}));
+	}
+
+	double _deltaBytes = -1;
+	if (selected(_filter, "delta")){
+		uint64 _random = _seed * 0xD6E8FEB86659FD93ULL + 1;
+		std::vector<std::vector<BoardState> > _streams;
+		std::vector<std::vector<uint8> > _encoded(_count);
+		uint64 _updates = 0, _bytes = 0;
+		for (size_t _i = 0; _i < _count; _i++){
+			_streams.push_back(buildStream(_corpus[_i], 4, _random));
+			_updates += _streams[_i].size() - 1;
+
+			DeltaEncoder _encoder;
+			uint8 _ops[deltaMaxUpdate];
+			for (size_t _s = 0; _s < _streams[_i].size(); _s++){
+				size_t _size = _encoder.encode(_streams[_i][_s], _ops);
+				_encoded[_i].insert(_encoded[_i].end(), _ops, _ops + _size);
+				if (_s > 0)
+					_bytes += _size;
+			}
+		}
+		_deltaBytes = _updates > 0 ? (double)_bytes / _updates : 0.0;
+
+		// Both count every state, the first (a keyframe) included
+		_results.push_back(measure("deltaEncode", _count, _minMS, 1, [&](size_t i){
+			DeltaEncoder _encoder;
+			uint8 _ops[deltaMaxUpdate];
+			const std::vector<BoardState>& _stream = _streams[i];
+			for (size_t _s = 0; _s < _stream.size(); _s++)
+				sink += _encoder.encode(_stream[_s], _ops);
+		}));
+		_results.back().operations = (_results.back().operations / _count) * (_updates + _count);
+
+		_results.push_back(measure("deltaDecode", _count, _minMS, 1, [&](size_t i){
+			DeltaDecoder _decoder;
+			const std::vector<uint8>& _ops = _encoded[i];
+			for (size_t _at = 0; _at < _ops.size(); _at += deltaOpSize(_ops[_at]))
+				_decoder.apply(&_ops[_at]);
+			sink += _decoder.getSequence();
+		}));
+		_results.back().operations = (_results.back().operations / _count) * (_updates + _count);
+	}
+
+	// Copying a game is part of several benchmarks above, reported so it can be subtracted
+	if (selected(_filter, "copy")){
+		_results.push_back(measure("copy", _count, _minMS, 1, [&](size_t i){
+			_work[i] = _corpus[i];
+			sink += _work[i].getBlockPosition().x;
+		}));
+	}
+
+	printf("{\n");
+	printf("  \"benchmark\": \"engine\",\n");
+	printf("  \"boards\": %d,\n", (int)_count);
+	printf("  \"seed\": %llu,\n", (unsigned long long)_seed);
+	if (_deltaBytes >= 0)
+		printf("  \"delta_bytes_per_update\": %.3f,\n", _deltaBytes);
+	printf("  \"results\": [\n");
+	for (size_t _r = 0; _r < _results.size(); _r++){
+		const Result& _result = _results[_r];
+		double _ns = _result.seconds * 1e9 / (double)_result.operations;
+		printf("    { \"name\": \"%s\", \"operations\": %llu, \"seconds\": %.6f, \"ns_per_op\": %.3f, \"ops_per_sec\": %.0f }%s\n",
+			_result.name, (unsigned long long)_result.operations, _result.seconds, _ns,
+			(double)_result.operations / _result.seconds, _r + 1 < _results.size() ? "," : "");
+	}
+	printf("  ]\n");
+	printf("}\n");
+
+	return sink == 0xFFFFFFFFFFFFFFFFULL ? 1 : 0;
+}
@@ -0,0 +1,308 @@
+/*Tetris
+Description: Perft for the engine, counts every distinct place a sequence of blocks can lock.
+
+			As with chess perft, the count at depth n is the number of placements at the n-th block
+			summed over every way of placing the blocks before it. Placements are found with the
+			game's own moveLeft/ moveRight/ rotateBlock/ dropDown on copies of the game so tucks
+			and spins are included, two placements are the same if they fill the same cells.
+			A placement that tops out ends that line, it counts but has nothing below it.
+
+			Counts come from MoveGen by default, --reference uses the search on game copies instead.
+			--validate checks both against known good counts for the built in positions, any change
+			to the rules or to MoveGen that changes a count is a regression.
+
+			Needs the Engine library only, on Linux:
+				g++ -O2 -std=c++14 -ISource Source/Tools/Perft.cpp Source/Engine/Game.cpp Source/Engine/MoveGen.cpp -o perft
+
+			Options:
+				--validate			Checks every built in position, exit code 1 on a mismatch
+				--position name		Runs one built in position (default: all)
+				--depth n			Overrides the depth of the position(s)
+				--reference			Counts with the search on game copies rather than MoveGen
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "../Engine/Game.h"
+#include "../Engine/MoveGen.h"
+
+namespace{
+
+	const int maxDepth = 8;
+
+	//!< Board + block sequence with the counts it must produce
+	struct Position{
+		const char* name;
+		const char* rows[Game::height];	//!< Bottom rows of the board, top first, '#' filled, NULL terminated
+		const char* sequence;			//!< Blocks in order, O I J L T S Z
+		int depth;
+		uint64 expected[maxDepth];		//!< Count at depth 1, 2, ...
+	};
+
+	const Position positions[] = {
+		{ "empty", { NULL }, "TLJS", 3,
+			{ 34, 1180, 41979 } },
+		{ "tuck", {
+			"####......",
+			"#.....####",
+			"#.#..#####",
+			"##########",
+			NULL }, "TZIO", 3,
+			{ 38, 683, 11988 } },
+		{ "clears", {
+			"##.#######",
+			"###.######",
+			"#######.##",
+			"####.#####",
+			NULL }, "IJLO", 3,
+			{ 17, 578, 20301 } },
+		{ "stack", {
+			"....#.....",
+			"...###....",
+			"#..####..#",
+			"##.####.##",
+			"##.####.##",
+			"##.#######",
+			NULL }, "SZTI", 3,
+			{ 17, 302, 11203 } },
+	};
+
+	int blockOf(char name){
+		const char* _names = "OIJLTSZ";
+		const char* _found = strchr(_names, name);
+		return _found != NULL && name != 0 ? (int)(_found - _names) : -1;
+	}
+
+	// Walls + the given bottom rows
+	void setupBoard(Game& game, const Position& position){
+		uint8 _grid[Game::cellCount];
+		memcpy(_grid, game.getGrid(), sizeof(_grid));
+
+		int _rows = 0;
+		while (_rows < Game::height && position.rows[_rows] != NULL)
+			_rows++;
+
+		for (int _r = 0; _r < _rows; _r++){
+			int _y = Game::height - _rows + _r;
+			for (int _x = 0; _x < Game::width - 2; _x++)
+				_grid[(_y * Game::width) + _x + 1] = position.rows[_r][_x] == '#' ? 1 : 0;
+		}
+		game.setGrid(_grid);
+	}
+
+	// Falling block layout + position, identifies a state of the search
+	uint64 stateKey(const Game& game){
+		const uint8* _block = game.getCurrentBlock();
+		uint64 _mask = 0;
+		for (int _i = 0; _i < 16; _i++)
+			_mask |= (uint64)(_block[_i] != 0) << _i;
+
+		Vec2 _position = game.getBlockPosition();
+		return _mask | ((uint64)(_position.x + 8) << 16) | ((uint64)(_position.y + 8) << 24);
+	}
+
+	// The cells the falling block covers, identifies a placement
+	uint64 placementKey(const Game& game){
+		const uint8* _block = game.getCurrentBlock();
+		Vec2 _position = game.getBlockPosition();
+		uint64 _key = 0;
+		for (int y = 0; y < 4; y++){
+			for (int x = 0; x < 4; x++){
+				if (_block[(y * 4) + x]){
+					// Offset so cells above the grid are still positive
+					int _cell = ((_position.y - 1 + y + 4) * Game::width) + _position.x - 1 + x;
+					_key = (_key << 9) | (uint64)_cell;
+				}
+			}
+		}
+		return _key;
+	}
+
+	//!< Result of placing the falling block
+	struct PlacedGame{
+		Game game;			//!< Block locked + lines cleared, no block spawned yet
+		bool toppedOut;
+	};
+
+	// Breadth first over every state the falling block can reach, one placement per distinct set of cells
+	void findPlacements(const Game& game, std::vector<PlacedGame>& placements){
+		std::unordered_set<uint64> _visited;
+		std::unordered_set<uint64> _placed;
+		std::deque<Game> _open;
+
+		_visited.insert(stateKey(game));
+		_open.push_back(game);
+
+		while (!_open.empty()){
+			Game _state = _open.front();
+			_open.pop_front();
+
+			// Same test dropDown() uses to decide the block locks
+			Vec2 _position = _state.getBlockPosition();
+			if (_state.checkCollision(_state.getCurrentBlock(), Vec2(_position.x, _position.y + 1))){
+				if (_placed.insert(placementKey(_state)).second){
+					PlacedGame _placement = { _state, false };
+					_placement.toppedOut = !_placement.game.placeBlock();
+					placements.push_back(_placement);
+				}
+			}
+
+			for (int _move = 0; _move < 4; _move++){
+				Game _next = _state;
+				bool _moved = false;
+				switch (_move){
+				case 0: _moved = _next.moveLeft(); break;
+				case 1: _moved = _next.moveRight(); break;
+				case 2: _moved = _next.rotateBlock(); break;
+				case 3: _moved = !_next.dropDown(); break;
+				}
+
+				if (_moved && _visited.insert(stateKey(_next)).second)
+					_open.push_back(_next);
+			}
+		}
+	}
+
+	// Adds the placements at each depth below game to counts, searching game copies
+	void perftReference(const Game& game, const char* sequence, int depth, int ply, uint64* counts){
+		std::vector<PlacedGame> _placements;
+		findPlacements(game, _placements);
+		counts[ply] += _placements.size();
+
+		if (ply + 1 >= depth)
+			return;
+
+		for (size_t _p = 0; _p < _placements.size(); _p++){
+			if (_placements[_p].toppedOut)
+				continue;
+
+			Game& _next = _placements[_p].game;
+			_next.spawn((uint8)blockOf(sequence[ply + 1]));
+			if (!_next.isGameOver())
+				perftReference(_next, sequence, depth, ply + 1, counts);
+		}
+	}
+
+	// As perftReference() with MoveGen, one generator per ply 
+	void perft(std::vector<MoveGen>& moveGens, const Game& game, const char* sequence, int depth, int ply, uint64* counts){
+		MoveGen& _moveGen = moveGens[ply];
+		int _count = _moveGen.generate(game);
+		counts[ply] += _count;
+
+		if (ply + 1 >= depth)
+			return;
+
+		for (int _p = 0; _p < _count; _p++){
+			Game _next = game;
+			if (!_moveGen.apply(_p, _next))
+				continue;
+
+			_next.spawn((uint8)blockOf(sequence[ply + 1]));
+			if (!_next.isGameOver())
+				perft(moveGens, _next, sequence, depth, ply + 1, counts);
+		}
+	}
+
+	// Runs a position, returns false if validating and a count differs
+	bool run(const Position& position, int depth, bool validate, bool reference){
+		Game _game;
+		_game.setEndless(false);
+		setupBoard(_game, position);
+		_game.spawn((uint8)blockOf(position.sequence[0]));
+
+		depth = std::min(depth, (int)strlen(position.sequence));
+
+		uint64 _counts[maxDepth] = {};
+		std::chrono::steady_clock::time_point _start = std::chrono::steady_clock::now();
+		if (reference){
+			perftReference(_game, position.sequence, depth, 0, _counts);
+		}
+		else{
+			std::vector<MoveGen> _moveGens(maxDepth);
+			perft(_moveGens, _game, position.sequence, depth, 0, _counts);
+		}
+		double _seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count();
+
+		uint64 _nodes = 0;
+		bool _ok = true;
+		for (int _d = 0; _d < depth; _d++){
+			_nodes += _counts[_d];
+			bool _match = _counts[_d] == position.expected[_d];
+			_ok = _ok && _match;
+
+			printf("%-8s %-9s depth %d: %12llu", position.name, reference ? "reference" : "movegen", _d + 1, (unsigned long long)_counts[_d]);
+			if (validate)
+				printf("  %s (expected %llu)", _match ? "ok" : "MISMATCH", (unsigned long long)position.expected[_d]);
+			printf("\n");
+		}
+		printf("%-8s %-9s %llu nodes in %.3fs, %.0f nodes/s\n", position.name, reference ? "reference" : "movegen", 
+			(unsigned long long)_nodes, _seconds,
+			_seconds > 0 ? _nodes / _seconds : 0);
+
+		return !validate || _ok;
+	}
+
+}
+
+int main(int argc, char** argv){
+	bool _validate = false;
+	bool _reference = false;
+	const char* _name = NULL;
+	int _depth = 0;
+
+	for (int _i = 1; _i < argc; _i++){
+		std::string _arg = argv[_i];
+		bool _hasValue = _i + 1 < argc;
+
+		if (_arg == "--validate")
+			_validate = true;
+		else if (_arg == "--position" && _hasValue)
+			_name = argv[++_i];
+		else if (_arg == "--reference")
+			_reference = true;
+		else if (_arg == "--depth" && _hasValue)
+			_depth = std::min(std::max(1, atoi(argv[++_i])), maxDepth);
+		else{
+			fprintf(stderr, "Unknown option: %s\n", _arg.c_str());
+			return 1;
+		}
+	}
+
+	// Known good counts only hold at the position's own depth
+	if (_validate)
+		_depth = 0;
+
+	bool _ok = true;
+	int _ran = 0;
+	for (size_t _p = 0; _p < sizeof(positions) / sizeof(positions[0]); _p++){
+		const Position& _position = positions[_p];
+		if (_name != NULL && strcmp(_name, _position.name) != 0)
+			continue;
+
+		int _positionDepth = _depth > 0 ? _depth : _position.depth;
+
+		// Validating cross checks MoveGen with the reference search
+		if (_validate || _reference)
+			_ok = run(_position, _positionDepth, _validate, true) && _ok;
+		if (_validate || !_reference)
+			_ok = run(_position, _positionDepth, _validate, false) && _ok;
+		_ran++;
+	}
+
+	if (_ran == 0){
+		fprintf(stderr, "Unknown position: %s\n", _name);
+		return 1;
+	}
+
+	if (_validate)
+		printf(_ok ? "perft: all counts match\n" : "perft: counts differ, the rules have changed\n");
+	return _ok ? 0 : 1;
+}
@@ -0,0 +1,186 @@
+/*Tetris
+Description: Bulk statistics over a replay corpus, one pass over the mapped files on a pool of threads.
+
+			Each file is split into one shard per thread (see ReplayReader::shard) and every
+			thread walks its shard's records in place, so the scan runs at the speed the disk
+			can deliver the pages. Totals are kept per thread and merged at the end, the same
+			way Tournament gathers its statistics.
+
+			Needs the Engine library only, on Linux:
+				g++ -O2 -std=c++14 -pthread -ISource Source/Tools/ReplayScan.cpp Source/Engine/Replay.cpp -o replayscan
+
+			Usage:
+				replayscan [--threads n] [--json file] replay...
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../Engine/Game.h"
+#include "../Engine/Replay.h"
+
+namespace{
+
+	//!< Totals for the games one thread scanned
+	struct ScanStats{
+		uint64 games = 0;
+		uint64 toppedOut = 0;
+		uint64 placements = 0;
+		uint64 lines = 0;
+		uint64 clears[4] = {};
+		uint64 blocks[Game::blockCount] = {};
+		uint32 longestGame = 0;
+		double thinkMS = 0;
+		float maxThinkMS = 0;
+		char padding[64];	//!< Keeps neighbouring threads' totals off the same cache line
+
+		void add(const ReplayGameView& view){
+			games++;
+			toppedOut += (view.game->rules & REPLAY_TOPPED_OUT) != 0;
+			placements += view.game->placementCount;
+			longestGame = std::max(longestGame, view.game->placementCount);
+
+			for (uint32 _p = 0; _p < view.game->placementCount; _p++){
+				const ReplayPlacement& _placement = view.placements[_p];
+				lines += _placement.lines;
+				if (_placement.lines > 0)
+					clears[std::min<int>(_placement.lines, 4) - 1]++;
+				blocks[_placement.block % Game::blockCount]++;
+				thinkMS += _placement.thinkMS;
+				maxThinkMS = std::max(maxThinkMS, _placement.thinkMS);
+			}
+		}
+
+		void merge(const ScanStats& other){
+			games += other.games;
+			toppedOut += other.toppedOut;
+			placements += other.placements;
+			lines += other.lines;
+			for (int _c = 0; _c < 4; _c++)
+				clears[_c] += other.clears[_c];
+			for (int _b = 0; _b < Game::blockCount; _b++)
+				blocks[_b] += other.blocks[_b];
+			longestGame = std::max(longestGame, other.longestGame);
+			thinkMS += other.thinkMS;
+			maxThinkMS = std::max(maxThinkMS, other.maxThinkMS);
+		}
+	};
+
+	struct Options{
+		int threads = 0;
+		const char* jsonPath = NULL;
+		std::vector<const char*> paths;
+	};
+
+	bool parseOptions(int argc, char** argv, Options& options){
+		for (int _i = 1; _i < argc; _i++){
+			std::string _arg = argv[_i];
+			bool _hasValue = _i + 1 < argc;
+
+			if (_arg == "--threads" && _hasValue)
+				options.threads = std::max(0, atoi(argv[++_i]));
+			else if (_arg == "--json" && _hasValue)
+				options.jsonPath = argv[++_i];
+			else if (_arg.compare(0, 2, "--") == 0){
+				fprintf(stderr, "Unknown option: %s\n", _arg.c_str());
+				return false;
+			}
+			else
+				options.paths.push_back(argv[_i]);
+		}
+
+		if (options.paths.empty()){
+			fprintf(stderr, "Usage: replayscan [--threads n] [--json file] replay...\n");
+			return false;
+		}
+		return true;
+	}
+
+	void writeJson(FILE* file, int threads, const ScanStats& total, uint64 bytes, double seconds){
+		double _games = (double)std::max<uint64>(total.games, 1);
+		double _placements = (double)std::max<uint64>(total.placements, 1);
+
+		fprintf(file, "{\n");
+		fprintf(file, "  \"threads\": %d,\n", threads);
+		fprintf(file, "  \"bytes\": %llu,\n", (unsigned long long)bytes);
+		fprintf(file, "  \"seconds\": %.3f,\n", seconds);
+		fprintf(file, "  \"mb_per_sec\": %.1f,\n", bytes / (1024.0 * 1024.0) / seconds);
+		fprintf(file, "  \"games\": %llu,\n", (unsigned long long)total.games);
+		fprintf(file, "  \"topped_out\": %llu,\n", (unsigned long long)total.toppedOut);
+		fprintf(file, "  \"placements\": { \"total\": %llu, \"mean\": %.2f, \"longest_game\": %u },\n",
+			(unsigned long long)total.placements, total.placements / _games, total.longestGame);
+		fprintf(file, "  \"lines\": { \"total\": %llu, \"mean\": %.2f },\n", (unsigned long long)total.lines, total.lines / _games);
+		fprintf(file, "  \"clears\": { \"single\": %llu, \"double\": %llu, \"triple\": %llu, \"tetris\": %llu },\n",
+			(unsigned long long)total.clears[0], (unsigned long long)total.clears[1],
+			(unsigned long long)total.clears[2], (unsigned long long)total.clears[3]);
+
+		fprintf(file, "  \"blocks\": [");
+		for (int _b = 0; _b < Game::blockCount; _b++)
+			fprintf(file, "%s%llu", _b > 0 ? ", " : " ", (unsigned long long)total.blocks[_b]);
+		fprintf(file, " ],\n");
+
+		fprintf(file, "  \"think_ms\": { \"mean\": %.4f, \"max\": %.4f }\n", total.thinkMS / _placements, total.maxThinkMS);
+		fprintf(file, "}\n");
+	}
+
+}
+
+int main(int argc, char** argv){
+	Options _options;
+	if (!parseOptions(argc, argv, _options))
+		return 1;
+
+	int _threads = _options.threads > 0 ? _options.threads : (int)std::thread::hardware_concurrency();
+	_threads = std::max(1, _threads);
+
+	std::vector<ScanStats> _stats(_threads);
+	uint64 _bytes = 0;
+
+	std::chrono::steady_clock::time_point _start = std::chrono::steady_clock::now();
+
+	for (size_t _f = 0; _f < _options.paths.size(); _f++){
+		ReplayReader _reader;
+		if (!_reader.open(_options.paths[_f])){
+			fprintf(stderr, "Not a replay file: %s\n", _options.paths[_f]);
+			return 1;
+		}
+		_bytes += _reader.getFileSize();
+
+		std::vector<std::thread> _workers;
+		for (int _w = 0; _w < _threads; _w++){
+			_workers.push_back(std::thread([&, _w](){
+				size_t _record, _end;
+				_reader.shard(_w, _threads, _record, _end);
+
+				ScanStats& _mine = _stats[_w];
+				ReplayGameView _view;
+				while (_reader.nextGame(_record, _end, _view))
+					_mine.add(_view);
+			}));
+		}
+		for (size_t _w = 0; _w < _workers.size(); _w++)
+			_workers[_w].join();
+	}
+
+	double _seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count();
+
+	ScanStats _total;
+	for (int _w = 0; _w < _threads; _w++)
+		_total.merge(_stats[_w]);
+
+	FILE* _json = _options.jsonPath != NULL ? fopen(_options.jsonPath, "w") : stdout;
+	if (_json == NULL){
+		fprintf(stderr, "Unable to write %s\n", _options.jsonPath);
+		return 1;
+	}
+	writeJson(_json, _threads, _total, _bytes, _seconds);
+	if (_json != stdout)
+		fclose(_json);
+
+	return 0;
+}
@@ -0,0 +1,367 @@
+/*Tetris
+Description: Spectator server + client on localhost, to watch a game or load test the server.
+
+			--serve plays a bot game and publishes it as the game does with --spectate-port.
+			--watch connects to a server and draws the board each time a block locks. --load
+			runs a server and n clients in one process with the game stepped as fast as it
+			will go, some of the clients reading slowly, then checks every client ended up with
+			the server's board and reports what was sent, skipped and dropped.
+
+			Linux only, as the server is. Needs the Engine library + SpectatorServer.cpp:
+				g++ -O2 -std=c++14 -pthread -ISource Source/Tools/Spectate.cpp Source/SpectatorServer.cpp \
+					Source/Engine/Game.cpp Source/Engine/MoveGen.cpp Source/Engine/Bot.cpp Source/Engine/Scheduler.cpp \
+					Source/Engine/TransTable.cpp Source/Engine/Encoders.cpp Source/Engine/DeltaCodec.cpp -o spectate
+
+			Options:
+				--serve				Play + publish a game
+				--watch				Connect and draw the game
+				--load n			Server + n clients in process (default mode, 16)
+				--port n			TCP port on 127.0.0.1 (default 7878)
+				--socket path		Unix socket instead of TCP
+				--seed n			Game seed (default 1)
+				--seconds n			How long to serve/ load test for (default 5, 0 serve forever)
+				--slow n			Load test clients that read slowly (default 2)
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../SpectatorServer.h"
+#include "../Engine/Bot.h"
+
+#if defined(__linux__)
+
+#include <errno.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace{
+
+	enum MODE{ MODE_SERVE, MODE_WATCH, MODE_LOAD };
+
+	struct Options{
+		MODE mode = MODE_LOAD;
+		int clients = 16;
+		int port = 7878;
+		const char* socketPath = NULL;
+		uint64 seed = 1;
+		double seconds = 5;
+		int slow = 2;
+	};
+
+	bool parseOptions(int argc, char** argv, Options& options){
+		for (int _i = 1; _i < argc; _i++){
+			std::string _arg = argv[_i];
+			bool _hasValue = _i + 1 < argc;
+
+			if (_arg == "--serve")
+				options.mode = MODE_SERVE;
+			else if (_arg == "--watch")
+				options.mode = MODE_WATCH;
+			else if (_arg == "--load" && _hasValue){
+				options.mode = MODE_LOAD;
+				options.clients = std::max(1, atoi(argv[++_i]));
+			}
+			else if (_arg == "--port" && _hasValue)
+				options.port = atoi(argv[++_i]);
+			else if (_arg == "--socket" && _hasValue)
+				options.socketPath = argv[++_i];
+			else if (_arg == "--seed" && _hasValue)
+				options.seed = strtoull(argv[++_i], NULL, 10);
+			else if (_arg == "--seconds" && _hasValue)
+				options.seconds = std::max(0.0, atof(argv[++_i]));
+			else if (_arg == "--slow" && _hasValue)
+				options.slow = std::max(0, atoi(argv[++_i]));
+			else{
+				fprintf(stderr, "Unknown option: %s\n", _arg.c_str());
+				return false;
+			}
+		}
+		return true;
+	}
+
+	int connectTo(const Options& options){
+		int _fd;
+		if (options.socketPath != NULL){
+			_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+			sockaddr_un _address = {};
+			_address.sun_family = AF_UNIX;
+			strncpy(_address.sun_path, options.socketPath, sizeof(_address.sun_path) - 1);
+			if (connect(_fd, (sockaddr*)&_address, sizeof(_address)) == 0)
+				return _fd;
+		}
+		else{
+			_fd = socket(AF_INET, SOCK_STREAM, 0);
+			sockaddr_in _address = {};
+			_address.sin_family = AF_INET;
+			_address.sin_port = htons((uint16)options.port);
+			_address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+			if (connect(_fd, (sockaddr*)&_address, sizeof(_address)) == 0)
+				return _fd;
+		}
+		close(_fd);
+		return -1;
+	}
+
+	//!< One connection's side of the stream
+	struct Client{
+		int fd = -1;
+		bool slow = false;
+		DeltaDecoder view;
+		uint64 ops = 0;
+		uint64 bytes = 0;
+		uint64 gaps = 0;			//!< Ops whose sequence was not the one after the last
+		bool failed = false;		//!< An op did not apply
+		std::vector<uint8> buffer;
+		std::atomic<uint32> latest{ 0 };	//!< Sequence applied so far, for other threads to read
+
+		// Applies every whole op in the buffer, calls onOp after each
+		template <typename F>
+		void parse(F onOp){
+			size_t _at = 0;
+			while (_at < buffer.size() && !failed){
+				size_t _size = deltaOpSize(buffer[_at]);
+				if (_size == 0){
+					failed = true;
+					break;
+				}
+				if (buffer.size() - _at < _size)
+					break;
+
+				uint32 _previous = view.getSequence();
+				bool _synced = view.isSynced();
+				view.apply(&buffer[_at]);
+				if (_synced && view.getSequence() != _previous + 1)
+					gaps++;
+				ops++;
+				latest.store(view.getSequence(), std::memory_order_relaxed);
+				onOp();
+				_at += _size;
+			}
+			buffer.erase(buffer.begin(), buffer.begin() + _at);
+		}
+
+		// Reads once, returns false when the server has gone
+		template <typename F>
+		bool read(F onOp){
+			uint8 _chunk[16384];
+			ssize_t _read = recv(fd, _chunk, slow ? 512 : sizeof(_chunk), 0);
+			if (_read <= 0)
+				return _read < 0 && errno == EINTR;
+			bytes += (uint64)_read;
+			buffer.insert(buffer.end(), _chunk, _chunk + _read);
+			parse(onOp);
+			return true;
+		}
+	};
+
+	void drawBoard(const BoardState& state){
+		char _rows[Game::height][boardColumns + 3];
+		for (int _y = 0; _y < Game::height; _y++){
+			_rows[_y][0] = '|';
+			for (int _x = 0; _x < boardColumns; _x++)
+				_rows[_y][1 + _x] = state.cells[(_y * boardColumns) + _x] != 0 ? '#' : '.';
+			_rows[_y][boardColumns + 1] = '|';
+			_rows[_y][boardColumns + 2] = 0;
+		}
+
+		// Falling block, same offsets as Game::checkCollision()
+		for (int _i = 0; _i < 16; _i++){
+			int _row = state.y - 1 + (_i / 4);
+			int _column = state.x - 2 + (_i % 4);
+			if ((state.layout & (1 << _i)) && _row >= 0 && _row < Game::height && _column >= 0 && _column < boardColumns)
+				_rows[_row][1 + _column] = '@';
+		}
+
+		printf("\x1b[H\x1b[2J");
+		for (int _y = 0; _y < Game::height; _y++)
+			printf("%s\n", _rows[_y]);
+		printf("lines %u blocks %u\n", state.lines, state.blocks);
+		fflush(stdout);
+	}
+
+	int runWatch(const Options& options){
+		Client _client;
+		_client.fd = connectTo(options);
+		if (_client.fd < 0){
+			fprintf(stderr, "Unable to connect\n");
+			return 1;
+		}
+
+		uint32 _blocks = (uint32)-1;
+		while (_client.read([&](){
+			if (_client.view.isSynced() && _client.view.getState().blocks != _blocks){
+				_blocks = _client.view.getState().blocks;
+				drawBoard(_client.view.getState());
+			}
+		})){}
+
+		close(_client.fd);
+		return _client.failed ? 1 : 0;
+	}
+
+	// Steps game with bot at rate ticks a second, or as fast as it goes (every tick an input) for 0
+	void playGame(Game& game, Bot& bot, SpectatorServer& server, int rate, double seconds){
+		typedef std::chrono::steady_clock Clock;
+		const float _tickMS = rate > 0 ? 1000.0f / rate : 50.0f;
+		Clock::time_point _start = Clock::now();
+		Clock::time_point _next = _start;
+
+		while (seconds <= 0 || std::chrono::duration<double>(Clock::now() - _start).count() < seconds){
+			bot.drive(game, _tickMS);
+			game.update(_tickMS);
+			server.publish(game);
+
+			if (rate > 0){
+				_next += std::chrono::microseconds(1000000 / rate);
+				std::this_thread::sleep_until(_next);
+			}
+		}
+	}
+
+	BotSettings botSettings(){
+		BotSettings _settings;
+		_settings.threads = 1;
+		_settings.tableMB = 1;
+		_settings.thinkMS = 1;
+		return _settings;
+	}
+
+	int runServe(const Options& options){
+		SpectatorServer _server;
+		if (!_server.start(options.socketPath != NULL ? 0 : options.port, options.socketPath)){
+			fprintf(stderr, "Unable to listen\n");
+			return 1;
+		}
+
+		Game _game(options.seed);
+		_game.newBlock();
+		Bot _bot(botSettings());
+		playGame(_game, _bot, _server, 1000, options.seconds);
+
+		fprintf(stderr, "%llu states, %llu bytes sent, %u clients\n", (unsigned long long)_server.statesEncoded(),
+			(unsigned long long)_server.bytesSent(), _server.clientCount());
+		return 0;
+	}
+
+	int runLoad(const Options& options){
+		SpectatorServer _server;
+		if (!_server.start(options.socketPath != NULL ? 0 : options.port, options.socketPath)){
+			fprintf(stderr, "Unable to listen\n");
+			return 1;
+		}
+
+		std::vector<Client> _clients(options.clients);
+		for (int _c = 0; _c < options.clients; _c++){
+			_clients[_c].slow = _c < options.slow;
+			_clients[_c].fd = connectTo(options);
+			if (_clients[_c].fd < 0){
+				fprintf(stderr, "Unable to connect\n");
+				return 1;
+			}
+			if (_clients[_c].slow){
+				int _small = 4096;
+				setsockopt(_clients[_c].fd, SOL_SOCKET, SO_RCVBUF, &_small, sizeof(_small));
+			}
+		}
+		while (_server.clientCount() < (uint32)options.clients)
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+		std::vector<std::thread> _readers;
+		for (int _c = 0; _c < options.clients; _c++){
+			_readers.push_back(std::thread([&, _c](){
+				Client& _client = _clients[_c];
+				while (_client.read([&](){
+					if (_client.slow && (_client.ops & 63) == 0)
+						std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				})){}
+			}));
+		}
+
+		Game _game(options.seed);
+		_game.newBlock();
+		Bot _bot(botSettings());
+		std::chrono::steady_clock::time_point _start = std::chrono::steady_clock::now();
+		playGame(_game, _bot, _server, 0, options.seconds);
+		double _seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count();
+
+		// Let the clients drain before closing, slow ones catch up through keyframes
+		BoardState _final;
+		boardState(_game, _final);
+		std::this_thread::sleep_for(std::chrono::milliseconds(500));
+		for (int _wait = 0; _wait < 100; _wait++){
+			bool _caughtUp = true;
+			for (size_t _c = 0; _c < _clients.size(); _c++)
+				_caughtUp = _caughtUp && _clients[_c].latest.load(std::memory_order_relaxed) == _server.lastSequence();
+			if (_caughtUp)
+				break;
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		}
+
+		uint64 _states = _server.statesEncoded();
+		uint32 _sequence = _server.lastSequence();
+		uint64 _sent = _server.bytesSent();
+		_server.stop();
+		for (size_t _r = 0; _r < _readers.size(); _r++)
+			_readers[_r].join();
+
+		int _matched = 0;
+		uint64 _clientOps = 0, _gaps = 0;
+		for (size_t _c = 0; _c < _clients.size(); _c++){
+			const Client& _client = _clients[_c];
+			_matched += !_client.failed && _client.view.getState() == _final;
+			_clientOps += _client.ops;
+			_gaps += _client.gaps;
+			close(_client.fd);
+		}
+
+		printf("{\n");
+		printf("  \"clients\": %d,\n", options.clients);
+		printf("  \"slow_clients\": %d,\n", std::min(options.slow, options.clients));
+		printf("  \"seconds\": %.3f,\n", _seconds);
+		printf("  \"states\": %llu,\n", (unsigned long long)_states);
+		printf("  \"states_per_sec\": %.1f,\n", _states / _seconds);
+		printf("  \"ops\": %u,\n", _sequence);
+		printf("  \"bytes_sent\": %llu,\n", (unsigned long long)_sent);
+		printf("  \"bytes_per_op\": %.2f,\n", _clientOps > 0 ? (double)_sent / _clientOps : 0.0);
+		printf("  \"states_dropped\": %llu,\n", (unsigned long long)_server.statesDropped());
+		printf("  \"clients_skipped\": %llu,\n", (unsigned long long)_server.clientsSkipped());
+		printf("  \"clients_dropped\": %llu,\n", (unsigned long long)_server.clientsDropped());
+		printf("  \"sequence_gaps\": %llu,\n", (unsigned long long)_gaps);
+		printf("  \"clients_matching\": %d\n", _matched);
+		printf("}\n");
+		return _matched + (int)_server.clientsDropped() == options.clients ? 0 : 1;
+	}
+
+}
+
+int main(int argc, char** argv){
+	Options _options;
+	if (!parseOptions(argc, argv, _options))
+		return 1;
+
+	switch (_options.mode){
+	case MODE_SERVE: return runServe(_options);
+	case MODE_WATCH: return runWatch(_options);
+	default: return runLoad(_options);
+	}
+}
+
+#else
+
+int main(){
+	fprintf(stderr, "The spectator server is Linux only\n");
+	return 1;
+}
+
+#endif
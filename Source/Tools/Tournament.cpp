@@ -0,0 +1,287 @@
+/*Tetris
+Description: Headless self play, runs many bot games on a pool of threads and reports the results.
+
+			Game n is played with seed + n so any game can be replayed on its own. Each worker
+			takes the next game from a shared counter, plays it with its own single threaded bot,
+			reset first so the game does not depend on which games the worker played before, and
+			writes the record into that game's slot; statistics are gathered per worker and
+			only merged once every game has finished, so workers never wait on each other.
+
+			Needs the Engine library only, on Linux:
+				g++ -O2 -std=c++14 -pthread -ISource Source/Tools/Tournament.cpp Source/Engine/Game.cpp Source/Engine/MoveGen.cpp \
+					Source/Engine/Bot.cpp Source/Engine/Match.cpp Source/Engine/Scheduler.cpp \
+					Source/Engine/TransTable.cpp Source/Engine/Encoders.cpp Source/Engine/Replay.cpp -o tournament
+
+			Options:
+				--games n			Games to play (default 1000)
+				--threads n			Worker threads (default one per core)
+				--seed n			Seed of game 0 (default 1)
+				--max-blocks n		Blocks after which a game counts as survived (default 1000)
+				--beam n			Bot beam width (default 32)
+				--lookahead n		Preview blocks the bot searches (default 2)
+				--think-ms n		Bot time budget per block (default 1000, effectively none so results repeat)
+				--csv file			One row per game
+				--json file			Summary (default stdout)
+				--replay file		Every game's placements as a replay file (see Replay.h), in the
+									order games finish, for ReplayScan and other bulk analysis
+				--validate			Plays the games on one thread with one bot kept across all of them
+									and again with a fresh bot for each, exit code 1 if any game is
+									placed differently (a bot's search must not depend on its past)
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../Engine/Match.h"
+
+namespace{
+
+	//!< Totals for the games one worker played
+	struct WorkerStats{
+		uint64 games = 0;
+		uint64 blocks = 0;
+		uint64 lines = 0;
+		uint64 clears[4] = {};
+		uint64 toppedOut = 0;
+		double thinkMS = 0;
+		float maxThinkMS = 0;
+		ThinkHistogram think;
+		char padding[64];	//!< Keeps neighbouring workers' totals off the same cache line
+
+		void add(const GameRecord& record){
+			games++;
+			blocks += record.blocks;
+			lines += record.lines;
+			for (int _c = 0; _c < 4; _c++)
+				clears[_c] += record.clears[_c];
+			toppedOut += record.toppedOut;
+			thinkMS += record.thinkMS;
+			maxThinkMS = std::max(maxThinkMS, record.maxThinkMS);
+		}
+
+		void merge(const WorkerStats& other){
+			games += other.games;
+			blocks += other.blocks;
+			lines += other.lines;
+			for (int _c = 0; _c < 4; _c++)
+				clears[_c] += other.clears[_c];
+			toppedOut += other.toppedOut;
+			thinkMS += other.thinkMS;
+			maxThinkMS = std::max(maxThinkMS, other.maxThinkMS);
+			think.merge(other.think);
+		}
+	};
+
+	struct Options{
+		int games = 1000;
+		int threads = 0;
+		uint64 seed = 1;
+		uint32 maxBlocks = 1000;
+		BotSettings bot;
+		const char* csvPath = NULL;
+		const char* jsonPath = NULL;
+		const char* replayPath = NULL;
+		bool validate = false;
+	};
+
+	bool parseOptions(int argc, char** argv, Options& options){
+		options.bot.thinkMS = 1000;
+		options.bot.threads = 1;	// Games are the unit of parallelism
+
+		for (int _i = 1; _i < argc; _i++){
+			std::string _arg = argv[_i];
+			bool _hasValue = _i + 1 < argc;
+
+			if (_arg == "--games" && _hasValue)
+				options.games = std::max(1, atoi(argv[++_i]));
+			else if (_arg == "--threads" && _hasValue)
+				options.threads = std::max(0, atoi(argv[++_i]));
+			else if (_arg == "--seed" && _hasValue)
+				options.seed = strtoull(argv[++_i], NULL, 10);
+			else if (_arg == "--max-blocks" && _hasValue)
+				options.maxBlocks = (uint32)std::max(1, atoi(argv[++_i]));
+			else if (_arg == "--beam" && _hasValue)
+				options.bot.beamWidth = atoi(argv[++_i]);
+			else if (_arg == "--lookahead" && _hasValue)
+				options.bot.lookahead = atoi(argv[++_i]);
+			else if (_arg == "--think-ms" && _hasValue)
+				options.bot.thinkMS = (float)atof(argv[++_i]);
+			else if (_arg == "--csv" && _hasValue)
+				options.csvPath = argv[++_i];
+			else if (_arg == "--json" && _hasValue)
+				options.jsonPath = argv[++_i];
+			else if (_arg == "--replay" && _hasValue)
+				options.replayPath = argv[++_i];
+			else if (_arg == "--validate")
+				options.validate = true;
+			else{
+				fprintf(stderr, "Unknown option: %s\n", _arg.c_str());
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool writeCsv(const char* path, const std::vector<GameRecord>& records){
+		FILE* _file = fopen(path, "w");
+		if (_file == NULL)
+			return false;
+
+		fprintf(_file, "game,seed,blocks,lines,singles,doubles,triples,tetrises,topped_out,think_ms,max_think_ms\n");
+		for (size_t _g = 0; _g < records.size(); _g++){
+			const GameRecord& _r = records[_g];
+			fprintf(_file, "%d,%llu,%u,%u,%u,%u,%u,%u,%d,%.3f,%.3f\n", (int)_g, (unsigned long long)_r.seed,
+				_r.blocks, _r.lines, _r.clears[0], _r.clears[1], _r.clears[2], _r.clears[3], _r.toppedOut ? 1 : 0,
+				_r.thinkMS, _r.maxThinkMS);
+		}
+
+		bool _ok = ferror(_file) == 0;
+		fclose(_file);
+		return _ok;
+	}
+
+	bool samePlacements(const std::vector<ReplayPlacement>& a, const std::vector<ReplayPlacement>& b){
+		if (a.size() != b.size())
+			return false;
+		for (size_t _p = 0; _p < a.size(); _p++){
+			if (a[_p].block != b[_p].block || a[_p].x != b[_p].x || a[_p].y != b[_p].y || a[_p].rotation != b[_p].rotation)
+				return false;
+		}
+		return true;
+	}
+
+	// Each game with a bot that has played every game before it against a fresh bot, returns the games that differ
+	int validate(const Options& options){
+		Bot _kept(options.bot);
+		std::vector<ReplayPlacement> _keptPlacements, _freshPlacements;
+		int _mismatches = 0;
+
+		for (int _g = 0; _g < options.games; _g++){
+			uint64 _seed = options.seed + _g;
+			_keptPlacements.clear();
+			_freshPlacements.clear();
+			GameRecord _record = playGame(_kept, _seed, options.maxBlocks, NULL, &_keptPlacements);
+
+			Bot _fresh(options.bot);
+			playGame(_fresh, _seed, options.maxBlocks, NULL, &_freshPlacements);
+
+			if (!samePlacements(_keptPlacements, _freshPlacements)){
+				fprintf(stderr, "Game %d (seed %llu): the kept bot plays it differently to a fresh one\n", _g, (unsigned long long)_seed);
+				_mismatches++;
+			}
+			else{
+				printf("Game %d: %u blocks %u lines, same\n", _g, _record.blocks, _record.lines);
+			}
+		}
+		return _mismatches;
+	}
+
+	void writeJson(FILE* file, const Options& options, int threads, const WorkerStats& total, double seconds){
+		double _games = (double)std::max<uint64>(total.games, 1);
+		double _blocks = (double)std::max<uint64>(total.blocks, 1);
+
+		fprintf(file, "{\n");
+		fprintf(file, "  \"games\": %llu,\n", (unsigned long long)total.games);
+		fprintf(file, "  \"threads\": %d,\n", threads);
+		fprintf(file, "  \"seed\": %llu,\n", (unsigned long long)options.seed);
+		fprintf(file, "  \"max_blocks\": %u,\n", options.maxBlocks);
+		fprintf(file, "  \"bot\": { \"beam\": %d, \"lookahead\": %d, \"think_ms\": %.3f },\n",
+			options.bot.beamWidth, options.bot.lookahead, options.bot.thinkMS);
+		fprintf(file, "  \"seconds\": %.3f,\n", seconds);
+		fprintf(file, "  \"games_per_sec\": %.3f,\n", total.games / seconds);
+		fprintf(file, "  \"blocks_per_sec\": %.1f,\n", total.blocks / seconds);
+		fprintf(file, "  \"blocks\": { \"total\": %llu, \"mean\": %.2f },\n", (unsigned long long)total.blocks, total.blocks / _games);
+		fprintf(file, "  \"lines\": { \"total\": %llu, \"mean\": %.2f },\n", (unsigned long long)total.lines, total.lines / _games);
+		fprintf(file, "  \"clears\": { \"single\": %llu, \"double\": %llu, \"triple\": %llu, \"tetris\": %llu },\n",
+			(unsigned long long)total.clears[0], (unsigned long long)total.clears[1],
+			(unsigned long long)total.clears[2], (unsigned long long)total.clears[3]);
+		fprintf(file, "  \"topped_out\": %llu,\n", (unsigned long long)total.toppedOut);
+		fprintf(file, "  \"think_ms\": { \"mean\": %.4f, \"p50\": %.4f, \"p99\": %.4f, \"max\": %.4f }\n",
+			total.thinkMS / _blocks, total.think.percentile(0.5), total.think.percentile(0.99), total.maxThinkMS);
+		fprintf(file, "}\n");
+	}
+
+}
+
+int main(int argc, char** argv){
+	Options _options;
+	if (!parseOptions(argc, argv, _options))
+		return 1;
+	if (_options.validate){
+		int _mismatches = validate(_options);
+		printf("%d of %d games differ\n", _mismatches, _options.games);
+		return _mismatches > 0 ? 1 : 0;
+	}
+
+	int _threads = _options.threads > 0 ? _options.threads : (int)std::thread::hardware_concurrency();
+	_threads = std::max(1, std::min(_threads, _options.games));
+
+	std::vector<GameRecord> _records(_options.games);
+	std::vector<WorkerStats> _stats(_threads);
+	std::atomic<int> _nextGame{ 0 };
+
+	ReplayWriter _replay;
+	if (_options.replayPath != NULL && !_replay.open(_options.replayPath)){
+		fprintf(stderr, "Unable to write %s\n", _options.replayPath);
+		return 1;
+	}
+
+	std::chrono::steady_clock::time_point _start = std::chrono::steady_clock::now();
+
+	std::vector<std::thread> _workers;
+	for (int _w = 0; _w < _threads; _w++){
+		_workers.push_back(std::thread([&, _w](){
+			Bot _bot(_options.bot);
+			WorkerStats& _mine = _stats[_w];
+			std::vector<ReplayPlacement> _placements;
+			std::vector<ReplayPlacement>* _keep = _options.replayPath != NULL ? &_placements : NULL;
+
+			for (;;){
+				int _game = _nextGame.fetch_add(1, std::memory_order_relaxed);
+				if (_game >= _options.games)
+					break;
+
+				_bot.reset();
+				_records[_game] = playGame(_bot, _options.seed + _game, _options.maxBlocks, &_mine.think, _keep);
+				_mine.add(_records[_game]);
+				if (_keep != NULL)
+					_replay.write(replayGame(_records[_game], (uint32)_placements.size()), _placements.data());
+			}
+		}));
+	}
+	for (size_t _w = 0; _w < _workers.size(); _w++)
+		_workers[_w].join();
+
+	double _seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count();
+
+	WorkerStats _total;
+	for (int _w = 0; _w < _threads; _w++)
+		_total.merge(_stats[_w]);
+
+	if (_options.replayPath != NULL && !_replay.close()){
+		fprintf(stderr, "Unable to write %s\n", _options.replayPath);
+		return 1;
+	}
+
+	if (_options.csvPath != NULL && !writeCsv(_options.csvPath, _records)){
+		fprintf(stderr, "Unable to write %s\n", _options.csvPath);
+		return 1;
+	}
+
+	FILE* _json = _options.jsonPath != NULL ? fopen(_options.jsonPath, "w") : stdout;
+	if (_json == NULL){
+		fprintf(stderr, "Unable to write %s\n", _options.jsonPath);
+		return 1;
+	}
+	writeJson(_json, _options, _threads, _total, _seconds);
+	if (_json != stdout)
+		fclose(_json);
+
+	return 0;
+}
@@ -0,0 +1,377 @@
+/*Tetris
+Description: Tunes the bot's feature weights with a genetic algorithm over self play.
+
+			A candidate is a weight vector scaled to unit length (the bot only compares scores so
+			the length does not matter). Its fitness is the mean lines cleared over a fixed set of
+			games, game n has seed game-seed + n for every candidate in every generation. Each
+			generation the weakest 30% are replaced by children: the two fittest of a random 10%
+			are averaged weighted by fitness, then sometimes nudged along one feature. Only the
+			children are played, games are shared out between threads one at a time and every
+			game gets a fresh single threaded bot, so the results do not depend on the threads.
+
+			The tuner's random numbers come from --seed alone, given the same options a run
+			gives the same weights on any machine. The population is written to the checkpoint
+			after each generation, --resume carries on from it.
+
+			Needs the Engine library only, on Linux:
+				g++ -O2 -std=c++14 -pthread -ISource Source/Tools/Tuner.cpp Source/Engine/Game.cpp Source/Engine/MoveGen.cpp \
+					Source/Engine/Bot.cpp Source/Engine/Match.cpp Source/Engine/Scheduler.cpp \
+					Source/Engine/TransTable.cpp Source/Engine/Encoders.cpp -o tuner
+
+			Options:
+				--population n		Candidates (default 64)
+				--generations n		Generations to run, counting any resumed from (default 50)
+				--games n			Games each candidate plays (default 16)
+				--game-seed n		Seed of game 0 (default 1)
+				--seed n			Tuner random seed (default 1)
+				--max-blocks n		Blocks after which a game stops (default 500)
+				--beam n			Bot beam width (default 8)
+				--lookahead n		Preview blocks the bot searches (default 1)
+				--threads n			Worker threads (default one per core)
+				--checkpoint file	Written after each generation (default tuner.chk)
+				--resume			Continues from the checkpoint
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../Engine/Match.h"
+
+namespace{
+
+	const float replaceFraction = 0.3f;		//!< Of the population, replaced each generation
+	const float tournamentFraction = 0.1f;	//!< Of the population, drawn to pick each pair of parents
+	const float mutationChance = 0.05f;
+	const float mutationSize = 0.2f;
+
+	//!< splitmix64, the whole state is one number so it goes in the checkpoint
+	struct Random{
+		uint64 state;
+
+		uint64 next(){
+			uint64 _z = (state += 0x9E3779B97F4A7C15ull);
+			_z = (_z ^ (_z >> 30)) * 0xBF58476D1CE4E5B9ull;
+			_z = (_z ^ (_z >> 27)) * 0x94D049BB133111EBull;
+			return _z ^ (_z >> 31);
+		}
+
+		//!< 0 to 1
+		float unit(){ return (float)(next() >> 40) / 16777216.0f; }
+		int below(int count){ return (int)(next() % (uint64)count); }
+	};
+
+	struct Candidate{
+		float weights[FEATURE_COUNT];
+		double fitness;
+		bool evaluated;
+	};
+
+	struct Options{
+		int population = 64;
+		int generations = 50;
+		int games = 16;
+		uint64 gameSeed = 1;
+		uint64 seed = 1;
+		uint32 maxBlocks = 500;
+		int beam = 8;
+		int lookahead = 1;
+		int threads = 0;
+		std::string checkpoint = "tuner.chk";
+		bool resume = false;
+	};
+
+	bool parseOptions(int argc, char** argv, Options& options){
+		for (int _i = 1; _i < argc; _i++){
+			std::string _arg = argv[_i];
+			bool _hasValue = _i + 1 < argc;
+
+			if (_arg == "--population" && _hasValue)
+				options.population = std::max(4, atoi(argv[++_i]));
+			else if (_arg == "--generations" && _hasValue)
+				options.generations = std::max(1, atoi(argv[++_i]));
+			else if (_arg == "--games" && _hasValue)
+				options.games = std::max(1, atoi(argv[++_i]));
+			else if (_arg == "--game-seed" && _hasValue)
+				options.gameSeed = strtoull(argv[++_i], NULL, 10);
+			else if (_arg == "--seed" && _hasValue)
+				options.seed = strtoull(argv[++_i], NULL, 10);
+			else if (_arg == "--max-blocks" && _hasValue)
+				options.maxBlocks = (uint32)std::max(1, atoi(argv[++_i]));
+			else if (_arg == "--beam" && _hasValue)
+				options.beam = std::max(1, atoi(argv[++_i]));
+			else if (_arg == "--lookahead" && _hasValue)
+				options.lookahead = std::max(0, atoi(argv[++_i]));
+			else if (_arg == "--threads" && _hasValue)
+				options.threads = std::max(0, atoi(argv[++_i]));
+			else if (_arg == "--checkpoint" && _hasValue)
+				options.checkpoint = argv[++_i];
+			else if (_arg == "--resume")
+				options.resume = true;
+			else{
+				fprintf(stderr, "Unknown option: %s\n", _arg.c_str());
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void normalise(float* weights){
+		float _length = 0;
+		for (int _f = 0; _f < FEATURE_COUNT; _f++)
+			_length += weights[_f] * weights[_f];
+		_length = std::sqrt(_length);
+		if (_length == 0)
+			return;
+		for (int _f = 0; _f < FEATURE_COUNT; _f++)
+			weights[_f] /= _length;
+	}
+
+	bool fitter(const Candidate& a, const Candidate& b){
+		return a.fitness > b.fitness;
+	}
+
+	// The bot's own weights + random ones
+	void initialPopulation(std::vector<Candidate>& population, int size, Random& random){
+		population.resize(size);
+		BotSettings _defaults;
+		for (int _c = 0; _c < size; _c++){
+			Candidate& _candidate = population[_c];
+			for (int _f = 0; _f < FEATURE_COUNT; _f++)
+				_candidate.weights[_f] = _c == 0 ? _defaults.weights[_f] : random.unit() * 2.0f - 1.0f;
+			normalise(_candidate.weights);
+			_candidate.fitness = 0;
+			_candidate.evaluated = false;
+		}
+	}
+
+	// Plays every game of every candidate not yet evaluated
+	void evaluate(std::vector<Candidate>& population, const Options& options, int threads){
+		std::vector<int> _pending;
+		for (size_t _c = 0; _c < population.size(); _c++){
+			if (!population[_c].evaluated)
+				_pending.push_back((int)_c);
+		}
+
+		int _jobs = (int)_pending.size() * options.games;
+		std::vector<uint32> _lines(_jobs);
+		std::atomic<int> _nextJob{ 0 };
+
+		std::vector<std::thread> _workers;
+		for (int _w = 0; _w < std::min(threads, _jobs); _w++){
+			_workers.push_back(std::thread([&](){
+				for (;;){
+					int _job = _nextJob.fetch_add(1, std::memory_order_relaxed);
+					if (_job >= _jobs)
+						break;
+
+					const Candidate& _candidate = population[_pending[_job / options.games]];
+					BotSettings _settings;
+					_settings.beamWidth = options.beam;
+					_settings.lookahead = options.lookahead;
+					_settings.thinkMS = 1e6f;		// No time limit, a slow machine must not change the result
+					_settings.threads = 1;
+					_settings.tableMB = 1;			// The bot only lives for one game
+					memcpy(_settings.weights, _candidate.weights, sizeof(_settings.weights));
+
+					Bot _bot(_settings);
+					_lines[_job] = playGame(_bot, options.gameSeed + _job % options.games, options.maxBlocks).lines;
+				}
+			}));
+		}
+		for (size_t _w = 0; _w < _workers.size(); _w++)
+			_workers[_w].join();
+
+		// Summed in game order, the same total whatever order the games finished in
+		for (size_t _p = 0; _p < _pending.size(); _p++){
+			Candidate& _candidate = population[_pending[_p]];
+			double _total = 0;
+			for (int _g = 0; _g < options.games; _g++)
+				_total += _lines[(_p * options.games) + _g];
+			_candidate.fitness = _total / options.games;
+			_candidate.evaluated = true;
+		}
+	}
+
+	// Replaces the weakest with children of the fittest, population sorted fittest first
+	void breed(std::vector<Candidate>& population, Random& random){
+		int _size = (int)population.size();
+		int _children = std::max(1, (int)(_size * replaceFraction));
+		int _drawn = std::max(2, (int)(_size * tournamentFraction));
+
+		std::vector<Candidate> _offspring(_children);
+		for (int _o = 0; _o < _children; _o++){
+			// Two fittest of the draw, the population is sorted so the lowest indices
+			int _first = _size, _second = _size;
+			for (int _d = 0; _d < _drawn; _d++){
+				int _index = random.below(_size);
+				if (_index < _first){
+					_second = _first;
+					_first = _index;
+				}
+				else if (_index < _second && _index != _first){
+					_second = _index;
+				}
+			}
+			if (_second == _size)
+				_second = _first;
+
+			const Candidate& _a = population[_first];
+			const Candidate& _b = population[_second];
+			double _total = _a.fitness + _b.fitness;
+			float _share = _total > 0 ? (float)(_a.fitness / _total) : 0.5f;
+
+			Candidate& _child = _offspring[_o];
+			for (int _f = 0; _f < FEATURE_COUNT; _f++)
+				_child.weights[_f] = (_a.weights[_f] * _share) + (_b.weights[_f] * (1.0f - _share));
+
+			if (random.unit() < mutationChance)
+				_child.weights[random.below(FEATURE_COUNT)] += (random.unit() * 2.0f - 1.0f) * mutationSize;
+
+			normalise(_child.weights);
+			_child.fitness = 0;
+			_child.evaluated = false;
+		}
+
+		for (int _o = 0; _o < _children; _o++)
+			population[_size - _children + _o] = _offspring[_o];
+	}
+
+	// Written to a temporary file first so a crash never leaves half a checkpoint
+	bool saveCheckpoint(const Options& options, int generation, const std::vector<Candidate>& population, const Random& random){
+		std::string _temporary = options.checkpoint + ".tmp";
+		FILE* _file = fopen(_temporary.c_str(), "w");
+		if (_file == NULL)
+			return false;
+
+		fprintf(_file, "tetris-tuner 1\n");
+		fprintf(_file, "generation %d\n", generation);
+		fprintf(_file, "random %llu\n", (unsigned long long)random.state);
+		fprintf(_file, "games %d %llu %u %d %d\n", options.games, (unsigned long long)options.gameSeed,
+			options.maxBlocks, options.beam, options.lookahead);
+		fprintf(_file, "population %d\n", (int)population.size());
+		for (size_t _c = 0; _c < population.size(); _c++){
+			const Candidate& _candidate = population[_c];
+			fprintf(_file, "%d %.17g", _candidate.evaluated ? 1 : 0, _candidate.fitness);
+			for (int _f = 0; _f < FEATURE_COUNT; _f++)
+				fprintf(_file, " %.9g", _candidate.weights[_f]);
+			fprintf(_file, "\n");
+		}
+
+		bool _ok = ferror(_file) == 0;
+		_ok = fclose(_file) == 0 && _ok;
+		if (!_ok)
+			return false;
+
+		remove(options.checkpoint.c_str());
+		return rename(_temporary.c_str(), options.checkpoint.c_str()) == 0;
+	}
+
+	// Fails if the file is unreadable or was made with different games
+	bool loadCheckpoint(const Options& options, int& generation, std::vector<Candidate>& population, Random& random){
+		FILE* _file = fopen(options.checkpoint.c_str(), "r");
+		if (_file == NULL){
+			fprintf(stderr, "Unable to read %s\n", options.checkpoint.c_str());
+			return false;
+		}
+
+		int _version = 0, _games = 0, _beam = 0, _lookahead = 0, _size = 0;
+		unsigned long long _random = 0, _gameSeed = 0;
+		unsigned int _maxBlocks = 0;
+		bool _ok = fscanf(_file, "tetris-tuner %d generation %d random %llu games %d %llu %u %d %d population %d",
+			&_version, &generation, &_random, &_games, &_gameSeed, &_maxBlocks, &_beam, &_lookahead, &_size) == 9 &&
+			_version == 1 && _size > 0;
+
+		if (_ok && (_games != options.games || _gameSeed != options.gameSeed || _maxBlocks != options.maxBlocks ||
+			_beam != options.beam || _lookahead != options.lookahead)){
+			fprintf(stderr, "%s was made with different games or bot settings\n", options.checkpoint.c_str());
+			fclose(_file);
+			return false;
+		}
+
+		population.resize(_ok ? _size : 0);
+		for (int _c = 0; _ok && _c < _size; _c++){
+			Candidate& _candidate = population[_c];
+			int _evaluated = 0;
+			_ok = fscanf(_file, "%d %lf", &_evaluated, &_candidate.fitness) == 2;
+			for (int _f = 0; _ok && _f < FEATURE_COUNT; _f++)
+				_ok = fscanf(_file, "%f", &_candidate.weights[_f]) == 1;
+			_candidate.evaluated = _evaluated != 0;
+		}
+		fclose(_file);
+
+		if (!_ok){
+			fprintf(stderr, "%s is not a tuner checkpoint\n", options.checkpoint.c_str());
+			return false;
+		}
+		random.state = _random;
+		return true;
+	}
+
+	void printWeights(const float* weights){
+		for (int _f = 0; _f < FEATURE_COUNT; _f++)
+			printf("%s%.6ff", _f == 0 ? "" : ", ", weights[_f]);
+	}
+
+}
+
+int main(int argc, char** argv){
+	Options _options;
+	if (!parseOptions(argc, argv, _options))
+		return 1;
+
+	int _threads = _options.threads > 0 ? _options.threads : (int)std::thread::hardware_concurrency();
+	_threads = std::max(_threads, 1);
+
+	std::vector<Candidate> _population;
+	Random _random = { _options.seed };
+	int _generation = 0;
+
+	if (_options.resume){
+		if (!loadCheckpoint(_options, _generation, _population, _random))
+			return 1;
+		printf("Resumed %s at generation %d\n", _options.checkpoint.c_str(), _generation);
+
+		// The checkpoint holds a finished generation
+		if (++_generation < _options.generations)
+			breed(_population, _random);
+	}
+	else{
+		initialPopulation(_population, _options.population, _random);
+	}
+
+	while (_generation < _options.generations){
+		evaluate(_population, _options, _threads);
+		std::stable_sort(_population.begin(), _population.end(), fitter);
+
+		double _mean = 0;
+		for (size_t _c = 0; _c < _population.size(); _c++)
+			_mean += _population[_c].fitness;
+		_mean /= _population.size();
+
+		printf("generation %d: best %.2f mean %.2f weights { ", _generation, _population[0].fitness, _mean);
+		printWeights(_population[0].weights);
+		printf(" }\n");
+		fflush(stdout);
+
+		if (!saveCheckpoint(_options, _generation, _population, _random)){
+			fprintf(stderr, "Unable to write %s\n", _options.checkpoint.c_str());
+			return 1;
+		}
+
+		if (++_generation < _options.generations)
+			breed(_population, _random);
+	}
+
+	std::stable_sort(_population.begin(), _population.end(), fitter);
+	printf("Best, %.2f lines a game: weights = { ", _population[0].fitness);
+	printWeights(_population[0].weights);
+	printf(" };\n");
+	return 0;
+}
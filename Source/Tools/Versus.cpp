@@ -0,0 +1,291 @@
+/*Tetris
+Description: Bot vs bot versus matches over UDP with rollback, to test the netcode.
+
+			--test (the default) forks two processes that play each other over loopback, with the
+			latency, jitter + loss given injected into both directions, then checks both ended the
+			match in the same state and neither saw a desync along the way. --player runs one side
+			only, for two terminals or two machines on a LAN.
+
+			Each side steps 60 frames a second. The bot thinks on the local game as this side
+			currently sees it and its input goes through the session like a player's would, only
+			one input every inputDelay + 1 frames so each lands before the next is decided.
+
+			Linux only, as VersusPeer is. Needs the Engine library + VersusPeer.cpp:
+				g++ -O2 -std=c++14 -pthread -ISource Source/Tools/Versus.cpp Source/VersusPeer.cpp \
+					Source/Engine/Game.cpp Source/Engine/MoveGen.cpp Source/Engine/Bot.cpp Source/Engine/Scheduler.cpp \
+					Source/Engine/TransTable.cpp Source/Engine/Encoders.cpp Source/Engine/Versus.cpp Source/Engine/Rollback.cpp -o versus
+
+			Options:
+				--test				Two processes on loopback (default)
+				--player n			Play side n (0 or 1) only
+				--port n			UDP port of side 0, side 1 uses port + 1 (default 7979)
+				--peer host			Address of the other side (default 127.0.0.1)
+				--seed n			Match seed (default 1)
+				--frames n			Frames to play (default 1800, 30 seconds)
+				--delay n			Local input delay in frames (default 2, at most 97)
+				--latency ms		Added one way latency (default 0)
+				--jitter ms			Up to this much more latency, reorders packets (default 0)
+				--loss pct			Packets dropped, percent (default 0)
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../VersusPeer.h"
+#include "../Engine/Bot.h"
+
+#if defined(__linux__)
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace{
+
+	struct Options{
+		bool test = true;
+		int player = 0;
+		int port = 7979;
+		const char* peer = "127.0.0.1";
+		uint64 seed = 1;
+		uint32 frames = 1800;
+		uint32 delay = 2;
+		float latencyMS = 0;
+		float jitterMS = 0;
+		float lossPercent = 0;
+	};
+
+	bool parseOptions(int argc, char** argv, Options& options){
+		for (int _i = 1; _i < argc; _i++){
+			std::string _arg = argv[_i];
+			bool _hasValue = _i + 1 < argc;
+
+			if (_arg == "--test")
+				options.test = true;
+			else if (_arg == "--player" && _hasValue){
+				options.test = false;
+				options.player = atoi(argv[++_i]) != 0 ? 1 : 0;
+			}
+			else if (_arg == "--port" && _hasValue)
+				options.port = atoi(argv[++_i]);
+			else if (_arg == "--peer" && _hasValue)
+				options.peer = argv[++_i];
+			else if (_arg == "--seed" && _hasValue)
+				options.seed = strtoull(argv[++_i], NULL, 10);
+			else if (_arg == "--frames" && _hasValue)
+				options.frames = (uint32)std::max(1, atoi(argv[++_i]));
+			else if (_arg == "--delay" && _hasValue){
+				options.delay = (uint32)std::max(0, atoi(argv[++_i]));
+				if (options.delay > RollbackSession::maxInputDelay){
+					fprintf(stderr, "--delay is at most %u frames\n", RollbackSession::maxInputDelay);
+					return false;
+				}
+			}
+			else if (_arg == "--latency" && _hasValue)
+				options.latencyMS = (float)std::max(0.0, atof(argv[++_i]));
+			else if (_arg == "--jitter" && _hasValue)
+				options.jitterMS = (float)std::max(0.0, atof(argv[++_i]));
+			else if (_arg == "--loss" && _hasValue)
+				options.lossPercent = (float)std::min(100.0, std::max(0.0, atof(argv[++_i])));
+			else{
+				fprintf(stderr, "Unknown option: %s\n", _arg.c_str());
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// The input the bot would make on game, found by letting it play one on a copy
+	uint8 botInput(Bot& bot, const Game& game){
+		if (game.isGameOver())
+			return 0;
+
+		Game _copy = game;
+		bot.drive(_copy, versusFrameMS);
+
+		if (memcmp(_copy.getCurrentBlock(), game.getCurrentBlock(), 16) != 0 && _copy.getBlocksPlaced() == game.getBlocksPlaced())
+			return VERSUS_ROTATE;
+		if (_copy.getBlockPosition().x < game.getBlockPosition().x && _copy.getBlocksPlaced() == game.getBlocksPlaced())
+			return VERSUS_LEFT;
+		if (_copy.getBlockPosition().x > game.getBlockPosition().x && _copy.getBlocksPlaced() == game.getBlocksPlaced())
+			return VERSUS_RIGHT;
+		if (_copy.getBlockPosition().y != game.getBlockPosition().y || _copy.getBlocksPlaced() != game.getBlocksPlaced())
+			return VERSUS_DROP;
+		return 0;
+	}
+
+	int runPlayer(const Options& options){
+		typedef std::chrono::steady_clock Clock;
+
+		VersusPeer _peer;
+		int _port = options.port + options.player;
+		int _peerPort = options.port + 1 - options.player;
+		if (!_peer.open(_port, options.peer, _peerPort)){
+			fprintf(stderr, "Unable to open UDP port %d\n", _port);
+			return 1;
+		}
+		_peer.setConditions(options.latencyMS, options.jitterMS, options.lossPercent, options.seed * 2 + options.player);
+
+		BotSettings _settings;
+		_settings.threads = 1;
+		_settings.tableMB = 1;
+		_settings.thinkMS = 2;
+		_settings.inputMS = 0;
+		Bot _bot(_settings);
+
+		RollbackSession* _session = new RollbackSession(options.seed, options.player, options.delay);
+		std::vector<float> _advanceUS;
+		uint32 _stalls = 0, _waits = 0;
+
+		const Clock::duration _frameTime = std::chrono::microseconds(1000000 / versusFrameRate);
+		Clock::time_point _next = Clock::now();
+		Clock::time_point _lastHeard = Clock::now();
+		uint64 _received = 0;
+		bool _done = false;
+
+		while (!_done){
+			_peer.poll(*_session);
+			if (_peer.packetsReceived() != _received){
+				_received = _peer.packetsReceived();
+				_lastHeard = Clock::now();
+			}
+			if (Clock::now() - _lastHeard > std::chrono::seconds(5)){
+				fprintf(stderr, "Player %d: peer went quiet\n", options.player);
+				break;
+			}
+
+			uint32 _frame = _session->getFrame();
+			if (_frame >= options.frames){
+				_session->synchronize();
+				_done = _session->getConfirmedEnd() >= options.frames;
+			}
+			else if (!_session->canAdvance()){
+				_stalls++;
+			}
+			else if (_session->framesAhead() > 0 && (_frame % 8) == 0){
+				_waits++;		// Gives the peer a frame to catch up, spread out so play stays smooth
+			}
+			else{
+				const Game& _game = _session->getMatch().getGame(options.player);
+				uint8 _input = (_frame % (options.delay + 1)) == 0 ? botInput(_bot, _game) : 0;
+
+				Clock::time_point _start = Clock::now();
+				_session->advance(_input);
+				_advanceUS.push_back(std::chrono::duration<float, std::micro>(Clock::now() - _start).count());
+			}
+			_peer.send(*_session);
+
+			_next += _frameTime;
+			std::this_thread::sleep_until(_next);
+		}
+
+		// Keeps sending so the peer gets the last of our input too
+		for (int _t = 0; _t < versusFrameRate; _t++){
+			_peer.poll(*_session);
+			_peer.send(*_session);
+			std::this_thread::sleep_for(_frameTime);
+		}
+
+		uint64 _checksum = 0;
+		bool _final = _session->confirmedChecksum(options.frames - 1, _checksum);
+		const VersusMatch& _match = _session->getMatch();
+
+		std::sort(_advanceUS.begin(), _advanceUS.end());
+		float _maxUS = _advanceUS.empty() ? 0 : _advanceUS.back();
+		float _p99US = _advanceUS.empty() ? 0 : _advanceUS[(_advanceUS.size() * 99) / 100];
+		double _totalUS = 0;
+		for (size_t _a = 0; _a < _advanceUS.size(); _a++)
+			_totalUS += _advanceUS[_a];
+
+		printf("{ \"player\": %d, \"frames\": %u, \"final\": %s, \"checksum\": \"%016llx\", ", options.player,
+			_match.getFrame(), _final ? "true" : "false", (unsigned long long)_checksum);
+		printf("\"winner\": %d, \"lines\": [%u, %u], \"garbage_sent\": [%u, %u], ", _match.isOver() ? _match.getWinner() : -2,
+			_match.getGame(0).getLinesCleared(), _match.getGame(1).getLinesCleared(), _match.getGarbageSent(0), _match.getGarbageSent(1));
+		printf("\"rollbacks\": %u, \"frames_replayed\": %llu, \"max_rollback\": %u, \"stalls\": %u, \"waits\": %u, ",
+			_session->getRollbacks(), (unsigned long long)_session->getFramesReplayed(), _session->getMaxRollback(), _stalls, _waits);
+		printf("\"advance_us\": { \"avg\": %.1f, \"p99\": %.1f, \"max\": %.1f }, ",
+			_advanceUS.empty() ? 0.0 : _totalUS / _advanceUS.size(), _p99US, _maxUS);
+		printf("\"packets\": { \"sent\": %llu, \"received\": %llu, \"dropped\": %llu }, ", (unsigned long long)_peer.packetsSent(),
+			(unsigned long long)_peer.packetsReceived(), (unsigned long long)_peer.packetsDropped());
+		printf("\"checksums_compared\": %llu, \"desyncs\": %llu }\n", (unsigned long long)_peer.checksumsCompared(),
+			(unsigned long long)_peer.desyncs());
+		fflush(stdout);
+
+		bool _ok = _final && _peer.desyncs() == 0 && _maxUS < versusFrameMS * 1000;
+		delete _session;
+		return _ok ? 0 : 1;
+	}
+
+	int runTest(const Options& options){
+		int _pipes[VersusMatch::players][2];
+		pid_t _children[VersusMatch::players];
+		for (int _p = 0; _p < VersusMatch::players; _p++){
+			if (pipe(_pipes[_p]) != 0)
+				return 1;
+			_children[_p] = fork();
+			if (_children[_p] == 0){
+				dup2(_pipes[_p][1], STDOUT_FILENO);
+				::close(_pipes[_p][0]);
+				Options _side = options;
+				_side.test = false;
+				_side.player = _p;
+				_exit(runPlayer(_side));
+			}
+			::close(_pipes[_p][1]);
+		}
+
+		std::string _results[VersusMatch::players];
+		bool _passed = true;
+		for (int _p = 0; _p < VersusMatch::players; _p++){
+			char _chunk[4096];
+			ssize_t _read;
+			while ((_read = read(_pipes[_p][0], _chunk, sizeof(_chunk))) > 0)
+				_results[_p].append(_chunk, (size_t)_read);
+			::close(_pipes[_p][0]);
+
+			int _status = 0;
+			waitpid(_children[_p], &_status, 0);
+			_passed = _passed && WIFEXITED(_status) && WEXITSTATUS(_status) == 0;
+			while (!_results[_p].empty() && _results[_p].back() == '\n')
+				_results[_p].pop_back();
+		}
+
+		// Both sides print the checksum of the same frame, played with the same inputs
+		size_t _at[VersusMatch::players];
+		for (int _p = 0; _p < VersusMatch::players; _p++)
+			_at[_p] = _results[_p].find("\"checksum\"");
+		bool _same = _at[0] != std::string::npos && _at[1] != std::string::npos &&
+			_results[0].compare(_at[0], 30, _results[1], _at[1], 30) == 0;
+
+		printf("{\n");
+		printf("  \"latency_ms\": %.1f, \"jitter_ms\": %.1f, \"loss_percent\": %.1f, \"input_delay\": %u,\n",
+			options.latencyMS, options.jitterMS, options.lossPercent, options.delay);
+		printf("  \"players\": [\n    %s,\n    %s\n  ],\n", _results[0].c_str(), _results[1].c_str());
+		printf("  \"same_final_state\": %s,\n", _same ? "true" : "false");
+		printf("  \"passed\": %s\n", _passed && _same ? "true" : "false");
+		printf("}\n");
+		return _passed && _same ? 0 : 1;
+	}
+
+}
+
+int main(int argc, char** argv){
+	Options _options;
+	if (!parseOptions(argc, argv, _options))
+		return 1;
+	return _options.test ? runTest(_options) : runPlayer(_options);
+}
+
+#else
+
+int main(){
+	fprintf(stderr, "Versus over UDP is Linux only\n");
+	return 1;
+}
+
+#endif
@@ -0,0 +1,217 @@
+#include "VersusPeer.h"
+
+#include <cstring>
+
+#if defined(__linux__)
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace{
+
+	const uint8 packetMagic = 'V';
+	const size_t headerSize = 1 + 4 + 1 + 4 + 4 + 8 + 4 + 1;
+
+	void put32(uint8*& out, uint32 value){
+		for (int _b = 0; _b < 4; _b++)
+			out[_b] = (uint8)(value >> (8 * _b));
+		out += 4;
+	}
+
+	void put64(uint8*& out, uint64 value){
+		put32(out, (uint32)value);
+		put32(out, (uint32)(value >> 32));
+	}
+
+	uint32 get32(const uint8*& in){
+		uint32 _value = 0;
+		for (int _b = 0; _b < 4; _b++)
+			_value |= (uint32)in[_b] << (8 * _b);
+		in += 4;
+		return _value;
+	}
+
+	uint64 get64(const uint8*& in){
+		uint64 _low = get32(in);
+		return _low | ((uint64)get32(in) << 32);
+	}
+
+}
+
+void VersusPeer::setConditions(float _latencyMS, float _jitterMS, float _lossPercent, uint64 seed){
+	latencyMS = _latencyMS;
+	jitterMS = _jitterMS;
+	lossPercent = _lossPercent;
+	randomState = (seed * 0x9E3779B97F4A7C15ULL) | 1;
+}
+
+uint32 VersusPeer::nextRandom(){
+	randomState ^= randomState >> 12;
+	randomState ^= randomState << 25;
+	randomState ^= randomState >> 27;
+	return (uint32)((randomState * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+void VersusPeer::send(const RollbackSession& session){
+	if (fd < 0)
+		return;
+
+	uint32 _end = session.getLocalInputEnd();
+	uint32 _first = peerAck;
+	if (_first + RollbackSession::historySize < _end)
+		_first = _end - RollbackSession::historySize;		// Gone from the history, the peer can not be waiting on it
+	uint32 _count = _end > _first ? _end - _first : 0;
+	if (_count > (uint32)maxInputs)
+		_count = maxInputs;
+
+	uint64 _checksum = 0;
+	uint32 _checksumFrame = session.getConfirmedEnd() - 1;
+	if (session.getConfirmedEnd() == 0 || !session.confirmedChecksum(_checksumFrame, _checksum))
+		_checksumFrame = RollbackSession::noFrame;
+
+	int _advantage = session.getLocalAdvantage();
+	_advantage = _advantage < -128 ? -128 : (_advantage > 127 ? 127 : _advantage);
+
+	uint8 _packet[headerSize + maxInputs];
+	uint8* _out = _packet;
+	*_out++ = packetMagic;
+	put32(_out, session.getFrame());
+	*_out++ = (uint8)(sint8)_advantage;
+	put32(_out, session.getRemoteInputEnd());
+	put32(_out, _checksumFrame);
+	put64(_out, _checksum);
+	put32(_out, _first);
+	*_out++ = (uint8)_count;
+	for (uint32 _i = 0; _i < _count; _i++)
+		*_out++ = session.getLocalInput(_first + _i);
+
+	size_t _size = (size_t)(_out - _packet);
+	sent++;
+
+	if (lossPercent > 0 && (nextRandom() % 10000) < (uint32)(lossPercent * 100)){
+		dropped++;
+		return;
+	}
+	if (latencyMS <= 0 && jitterMS <= 0){
+		transmit(_packet, _size);
+		return;
+	}
+
+	// Jitter can reorder packets, as a real network does
+	float _delayMS = latencyMS + (jitterMS > 0 ? jitterMS * (nextRandom() % 1000) / 1000.0f : 0);
+	Delayed _delayed;
+	_delayed.due = Clock::now() + std::chrono::microseconds((long long)(_delayMS * 1000));
+	_delayed.bytes.assign(_packet, _packet + _size);
+	delayed.push_back(_delayed);
+}
+
+#if defined(__linux__)
+
+bool VersusPeer::open(int localPort, const char* peerHost, int peerPort){
+	close();
+
+	sockaddr_in _peer = {};
+	_peer.sin_family = AF_INET;
+	_peer.sin_port = htons((uint16)peerPort);
+	if (inet_pton(AF_INET, peerHost, &_peer.sin_addr) != 1)
+		return false;
+	memcpy(peerAddress, &_peer, sizeof(_peer));
+
+	fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (fd < 0)
+		return false;
+
+	sockaddr_in _address = {};
+	_address.sin_family = AF_INET;
+	_address.sin_port = htons((uint16)localPort);
+	_address.sin_addr.s_addr = htonl(INADDR_ANY);
+	if (bind(fd, (sockaddr*)&_address, sizeof(_address)) != 0){
+		close();
+		return false;
+	}
+
+	peerAck = 0;
+	delayed.clear();
+	return true;
+}
+
+void VersusPeer::close(){
+	if (fd >= 0)
+		::close(fd);
+	fd = -1;
+}
+
+void VersusPeer::transmit(const uint8* bytes, size_t size){
+	// A full socket buffer loses the packet, the next one carries the same input
+	ssize_t _sent = sendto(fd, bytes, size, MSG_DONTWAIT, (const sockaddr*)peerAddress, sizeof(sockaddr_in));
+	(void)_sent;
+}
+
+void VersusPeer::poll(RollbackSession& session){
+	if (fd < 0)
+		return;
+
+	Clock::time_point _now = Clock::now();
+	for (size_t _d = 0; _d < delayed.size();){
+		if (delayed[_d].due <= _now){
+			transmit(&delayed[_d].bytes[0], delayed[_d].bytes.size());
+			delayed[_d] = delayed.back();
+			delayed.pop_back();
+		}
+		else{
+			_d++;
+		}
+	}
+
+	uint8 _packet[headerSize + maxInputs];
+	for (;;){
+		ssize_t _size = recv(fd, _packet, sizeof(_packet), MSG_DONTWAIT);
+		if (_size < 0)
+			return;
+		if ((size_t)_size < headerSize || _packet[0] != packetMagic)
+			continue;
+
+		const uint8* _in = _packet + 1;
+		uint32 _frame = get32(_in);
+		int _advantage = (sint8)*_in++;
+		uint32 _ack = get32(_in);
+		uint32 _checksumFrame = get32(_in);
+		uint64 _checksum = get64(_in);
+		uint32 _first = get32(_in);
+		uint32 _count = *_in++;
+		if ((size_t)_size != headerSize + _count)
+			continue;
+
+		received++;
+		for (uint32 _i = 0; _i < _count; _i++)
+			session.addRemoteInput(_first + _i, _in[_i]);
+		session.addRemoteStatus(_frame, _advantage);
+		if (_ack > peerAck)
+			peerAck = _ack;
+
+		uint64 _ours;
+		if (_checksumFrame != RollbackSession::noFrame && session.confirmedChecksum(_checksumFrame, _ours)){
+			compared++;
+			desynced += _ours != _checksum;
+		}
+	}
+}
+
+#else
+
+bool VersusPeer::open(int, const char*, int){
+	return false;
+}
+
+void VersusPeer::close(){
+}
+
+void VersusPeer::transmit(const uint8*, size_t){
+}
+
+void VersusPeer::poll(RollbackSession&){
+}
+
+#endif
@@ -0,0 +1,81 @@
+/*Tetris
+Description: UDP transport between the two RollbackSessions of a versus match.
+
+			Every packet carries all of the sender's input the peer has not acknowledged yet, so a
+			lost packet costs nothing but the time until the next one, there are no resends or
+			timers. Each also carries the sender's frame + advantage for time sync and the checksum
+			of its newest confirmed frame, compared against ours to count desyncs.
+
+			setConditions() delays, jitters and drops packets on the way out, so latency + loss can
+			be tested with two processes on one machine.
+
+			Packet, little endian: 'V', frame (uint32), advantage (sint8), ack (uint32, remote input
+			end), checksum frame (uint32), checksum (uint64), first input frame (uint32), count
+			(uint8), then count inputs.
+
+			Linux only, open() returns false elsewhere.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+#include "Common.h"
+#include "Engine/Rollback.h"
+
+class VersusPeer{
+public:
+	static const int maxInputs = 64;		//!< Inputs in one packet
+
+	VersusPeer() {}
+	~VersusPeer() { close(); }
+
+	//!< Listens on localPort (any address, so a LAN peer can reach it) and sends to peerHost
+	//!< (dotted IPv4) : peerPort. Returns false if the socket could not be set up.
+	bool open(int localPort, const char* peerHost, int peerPort);
+	void close();
+
+	//!< Every packet sent from now on waits latencyMS + up to jitterMS, lossPercent of them are dropped
+	void setConditions(float latencyMS, float jitterMS, float lossPercent, uint64 seed);
+
+	//!< Reads every packet waiting into session and sends delayed packets that are due, never blocks
+	void poll(RollbackSession& session);
+
+	//!< Sends the local input the peer has not acknowledged
+	void send(const RollbackSession& session);
+
+	uint64 packetsSent() const { return sent; }
+	uint64 packetsReceived() const { return received; }
+	uint64 packetsDropped() const { return dropped; }		//!< By setConditions()
+	uint64 checksumsCompared() const { return compared; }
+	uint64 desyncs() const { return desynced; }
+	uint32 getPeerAck() const { return peerAck; }			//!< Local input frames the peer has
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	struct Delayed{
+		Clock::time_point due;
+		std::vector<uint8> bytes;
+	};
+
+	void transmit(const uint8* bytes, size_t size);
+	uint32 nextRandom();
+
+	int fd = -1;
+	uint8 peerAddress[16];			//!< sockaddr_in
+	uint32 peerAck = 0;
+
+	float latencyMS = 0;
+	float jitterMS = 0;
+	float lossPercent = 0;
+	uint64 randomState = 1;
+	std::vector<Delayed> delayed;
+
+	uint64 sent = 0;
+	uint64 received = 0;
+	uint64 dropped = 0;
+	uint64 compared = 0;
+	uint64 desynced = 0;
+};